@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include "harness.hpp"
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace nnn {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+double runIterations(const std::function<void()>& body, int iterations) {
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    return elapsedNs(start);
+}
+
+// Nearest-rank percentile of sorted `values`.
+double percentile(const std::vector<double>& values, double fraction) {
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+    return values[std::max<std::size_t>(rank, 1) - 1];
+}
+
+// Names are generated by the benchmarks themselves, but are escaped anyway so that the file is always valid JSON.
+std::string quoted(const std::string& text) {
+    std::string result = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + '"';
+}
+
+// Value of `"key": ` on a line written by `writeJson`, or the empty string.
+std::string field(const std::string& line, const std::string& key) {
+    const std::string prefix = quoted(key) + ": ";
+    const std::size_t start = line.find(prefix);
+    if (start == std::string::npos) {
+        return {};
+    }
+    std::size_t begin = start + prefix.size();
+    if (begin < line.size() && line[begin] == '"') {
+        ++begin;
+        return line.substr(begin, line.find('"', begin) - begin);
+    }
+    return line.substr(begin, line.find_first_of(",}", begin) - begin);
+}
+
+} // namespace
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options) : options(options) {
+    if (options.repetitions < 1 || options.warmupIterations < 0) {
+        throw std::runtime_error("BenchmarkRunner::BenchmarkRunner: invalid repetition counts");
+    }
+}
+
+bool BenchmarkRunner::isSelected(const std::string& name) const {
+    return name.find(options.filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string& name, const BenchmarkWork& work, const std::function<void()>& body) {
+    if (!isSelected(name)) {
+        return;
+    }
+    if (options.dryRun) {
+        results.push_back({ name, work });
+        return;
+    }
+
+    runIterations(body, options.warmupIterations);
+    // Calibrate on one more iteration: fast bodies are batched so that every sample lasts minSampleSeconds.
+    const double single = std::max(runIterations(body, 1), 1.);
+    const double target = options.minSampleSeconds * 1e9;
+    const int iterations = static_cast<int>(std::clamp(std::ceil(target / single), 1., 1e9));
+
+    std::vector<double> samples(options.repetitions);
+    for (double& sample : samples) {
+        sample = runIterations(body, iterations) / iterations;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.work = work;
+    result.iterationsPerSample = iterations;
+    result.samples = options.repetitions;
+    result.medianNs = percentile(samples, 0.5);
+    result.p99Ns = percentile(samples, 0.99);
+    result.minNs = samples.front();
+    result.meanNs = std::accumulate(samples.begin(), samples.end(), 0.) / static_cast<double>(samples.size());
+    results.push_back(result);
+}
+
+const std::vector<BenchmarkResult>& BenchmarkRunner::getResults() const {
+    return results;
+}
+
+void BenchmarkRunner::printTable(std::ostream& stream) const {
+    stream << std::left << std::setw(44) << "benchmark" << std::right
+        << std::setw(14) << "median us" << std::setw(14) << "p99 us"
+        << std::setw(12) << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(14) << "items/s" << '\n';
+    stream << std::fixed;
+    for (const BenchmarkResult& result : results) {
+        const double seconds = result.medianNs * 1e-9;
+        stream << std::left << std::setw(44) << result.name << std::right << std::setprecision(2)
+            << std::setw(14) << result.medianNs * 1e-3 << std::setw(14) << result.p99Ns * 1e-3;
+        stream << std::setprecision(1);
+        if (result.work.flops > 0.) {
+            stream << std::setw(12) << result.work.flops / seconds * 1e-9;
+        } else {
+            stream << std::setw(12) << '-';
+        }
+        if (result.work.bytes > 0.) {
+            stream << std::setw(10) << result.work.bytes / seconds * 1e-9;
+        } else {
+            stream << std::setw(10) << '-';
+        }
+        if (result.work.items > 0.) {
+            stream << std::setprecision(0) << std::setw(14) << result.work.items / seconds;
+        } else {
+            stream << std::setw(14) << '-';
+        }
+        stream << '\n';
+    }
+    stream << std::defaultfloat;
+}
+
+void BenchmarkRunner::writeJson(const std::string& path, const std::map<std::string, std::string>& context) const {
+    std::ofstream stream(path, std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("BenchmarkRunner::writeJson: cannot open `" + path + "`");
+    }
+
+    stream << std::setprecision(std::numeric_limits<double>::max_digits10);
+    stream << "{\n  \"version\": 1,\n  \"context\": {";
+    const char* separator = "";
+    for (const auto& [key, value] : context) {
+        stream << separator << quoted(key) << ": " << quoted(value);
+        separator = ", ";
+    }
+    stream << "},\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        stream << "    {\"name\": " << quoted(result.name)
+            << ", \"median_ns\": " << result.medianNs
+            << ", \"p99_ns\": " << result.p99Ns
+            << ", \"min_ns\": " << result.minNs
+            << ", \"mean_ns\": " << result.meanNs
+            << ", \"samples\": " << result.samples
+            << ", \"iterations_per_sample\": " << result.iterationsPerSample
+            << ", \"flops\": " << result.work.flops
+            << ", \"bytes\": " << result.work.bytes
+            << ", \"items\": " << result.work.items
+            << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    stream << "  ]\n}\n";
+    if (!stream) {
+        throw std::runtime_error("BenchmarkRunner::writeJson: cannot write `" + path + "`");
+    }
+}
+
+double BenchmarkRunner::compare(const std::string& baseline, std::ostream& stream) const {
+    std::ifstream file(baseline);
+    if (!file) {
+        throw std::runtime_error("BenchmarkRunner::compare: cannot open `" + baseline + "`");
+    }
+    std::map<std::string, double> medians;
+    for (std::string line; std::getline(file, line);) {
+        const std::string name = field(line, "name");
+        const std::string median = field(line, "median_ns");
+        if (!name.empty() && !median.empty()) {
+            medians[name] = std::stod(median);
+        }
+    }
+
+    double worst = -std::numeric_limits<double>::infinity();
+    stream << std::left << std::setw(44) << "benchmark" << std::right
+        << std::setw(14) << "baseline us" << std::setw(14) << "median us" << std::setw(10) << "change" << '\n';
+    stream << std::fixed << std::setprecision(2);
+    for (const BenchmarkResult& result : results) {
+        const auto found = medians.find(result.name);
+        if (found == medians.end()) {
+            continue;
+        }
+        const double change = (result.medianNs / found->second - 1.) * 100.;
+        worst = std::max(worst, change);
+        stream << std::left << std::setw(44) << result.name << std::right
+            << std::setw(14) << found->second * 1e-3 << std::setw(14) << result.medianNs * 1e-3
+            << std::setw(9) << std::showpos << change << std::noshowpos << "%\n";
+    }
+    stream << std::defaultfloat;
+    if (worst == -std::numeric_limits<double>::infinity()) {
+        stream << "no benchmark of this run is in the baseline\n";
+        return 0.;
+    }
+    return worst;
+}
+
+} // nnn
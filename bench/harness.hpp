@@ -0,0 +1,69 @@
+#ifndef HARNESS_HPP
+#define HARNESS_HPP
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nnn {
+
+struct BenchmarkOptions {
+    // Untimed iterations before sampling, to fault in buffers and let caches and pools settle.
+    int warmupIterations = 3;
+    // Timed samples per benchmark; the median and p99 are taken over these.
+    int repetitions = 30;
+    // Each sample runs enough iterations to last at least this long, so timer resolution does not matter.
+    double minSampleSeconds = 1e-3;
+    // Only benchmarks whose name contains this are run.
+    std::string filter;
+    // Records the selected names without running anything.
+    bool dryRun = false;
+};
+
+// Work done by one iteration, from which rates are derived. Zero means "not applicable".
+struct BenchmarkWork {
+    double flops = 0.;
+    // Bytes the iteration has to read and write at least, e.g. the operands and result of a product.
+    double bytes = 0.;
+    // Domain units, e.g. samples for a forward pass.
+    double items = 0.;
+};
+
+// Per-iteration times in nanoseconds.
+struct BenchmarkResult {
+    std::string name;
+    BenchmarkWork work;
+    int iterationsPerSample = 0;
+    int samples = 0;
+    double medianNs = 0.;
+    double p99Ns = 0.;
+    double minNs = 0.;
+    double meanNs = 0.;
+};
+
+// Runs benchmarks one after another on the calling thread and collects their statistics.
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+    [[nodiscard]] bool isSelected(const std::string& name) const;
+    // Times `body`, which runs one iteration; setup belongs outside of it. Does nothing if `name` is filtered out.
+    void run(const std::string& name, const BenchmarkWork& work, const std::function<void()>& body);
+
+    [[nodiscard]] const std::vector<BenchmarkResult>& getResults() const;
+    void printTable(std::ostream& stream) const;
+    // One benchmark object per line, so that runs can also be diffed as text. `context` is stored as strings.
+    void writeJson(const std::string& path, const std::map<std::string, std::string>& context) const;
+    // Prints each benchmark's median against the one of the same name in `baseline`, a file written by
+    // `writeJson`. Returns the largest slowdown in percent (negative if everything got faster).
+    double compare(const std::string& baseline, std::ostream& stream) const;
+
+private:
+    BenchmarkOptions options;
+    std::vector<BenchmarkResult> results;
+};
+
+} // nnn
+
+#endif //HARNESS_HPP
@@ -0,0 +1,325 @@
+#include "activation_function.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include "gemm.hpp"
+#include "harness.hpp"
+#include <iostream>
+#include "layer.hpp"
+#include "matrix.hpp"
+#include "neural_network.hpp"
+#include "random.hpp"
+#include <stdexcept>
+#include <string>
+#include "thread_pool.hpp"
+#include "training.hpp"
+#include <vector>
+
+using namespace nnn;
+
+namespace {
+
+constexpr const char* USAGE =
+    "usage: nnn_bench [options]\n"
+    "  --filter TEXT          run only benchmarks whose name contains TEXT\n"
+    "  --json PATH            write the results as JSON\n"
+    "  --baseline PATH        compare medians against a JSON file written by --json\n"
+    "  --max-regression PCT   exit with status 2 if a median is more than PCT% slower than the baseline\n"
+    "  --repetitions N        timed samples per benchmark (default 30)\n"
+    "  --warmup N             untimed iterations per benchmark (default 3)\n"
+    "  --min-sample-time S    minimum seconds per sample (default 0.001)\n"
+    "  --threads N            thread pool size (default: hardware concurrency)\n"
+    "  --list                 print the benchmark names without running them\n";
+
+// Filled with deterministic values, so that runs of the same build do the same work.
+template<typename T>
+BasicMatrix<T> randomMatrix(int rows, int cols, std::uint64_t seed) {
+    BasicMatrix<T> matrix(rows, cols);
+    Random random(seed);
+    matrix.randomize(T(-1), T(1), random);
+    return matrix;
+}
+
+std::string shapeName(int m, int n, int k) {
+    return std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k);
+}
+
+std::string topologyName(const std::vector<int>& sizes) {
+    std::string name;
+    for (const int size : sizes) {
+        if (!name.empty()) {
+            name += '-';
+        }
+        name += std::to_string(size);
+    }
+    return name;
+}
+
+double gemmFlops(int m, int n, int k) {
+    return 2. * m * n * k;
+}
+
+double networkFlops(const std::vector<int>& sizes, int batch) {
+    double flops = 0.;
+    for (std::size_t i = 0; i + 1 < sizes.size(); ++i) {
+        flops += gemmFlops(batch, sizes[i + 1], sizes[i]);
+    }
+    return flops;
+}
+
+// `C = A * B` for each kernel the CPU supports, and the transposed forms used by backpropagation.
+void benchmarkGemm(BenchmarkRunner& runner) {
+    const int shapes[][3] = { { 64, 64, 64 }, { 128, 128, 128 }, { 256, 256, 256 }, { 256, 128, 784 } };
+    const GemmKernel kernels[] = { GemmKernel::Scalar, GemmKernel::Avx2, GemmKernel::Avx512 };
+    for (const GemmKernel kernel : kernels) {
+        if (!Gemm::setKernel(kernel)) {
+            continue;
+        }
+        for (const auto& [m, n, k] : shapes) {
+            const Matrix a = randomMatrix<float>(m, k, 1);
+            const Matrix b = randomMatrix<float>(k, n, 2);
+            Matrix c;
+            runner.run(
+                std::string("gemm/") + Gemm::kernelName(kernel) + "/" + shapeName(m, n, k),
+                { gemmFlops(m, n, k), 4. * (m * k + k * n + m * n), 0. },
+                [&] { Matrix::multiplyInto(c, a, b); }
+            );
+        }
+    }
+    Gemm::setKernel(GemmKernel::Auto);
+
+    const int n = 512;
+    const Matrix a = randomMatrix<float>(n, n, 1);
+    const Matrix b = randomMatrix<float>(n, n, 2);
+    Matrix c;
+    const BenchmarkWork work = { gemmFlops(n, n, n), 4. * 3 * n * n, 0. };
+    runner.run("gemm/auto/" + shapeName(n, n, n), work, [&] { Matrix::multiplyInto(c, a, b); });
+    runner.run("gemm/auto/tn/" + shapeName(n, n, n), work, [&] {
+        Matrix::multiplyInto(c, a, Transpose::Yes, b, Transpose::No);
+    });
+    runner.run("gemm/auto/nt/" + shapeName(n, n, n), work, [&] {
+        Matrix::multiplyInto(c, a, Transpose::No, b, Transpose::Yes);
+    });
+    runner.run("transpose/" + std::to_string(n) + "x" + std::to_string(n), { 0., 4. * 2 * n * n, 0. }, [&] {
+        Matrix::transposeInto(c, a);
+    });
+
+    const int m = 256;
+    const DoubleMatrix da = randomMatrix<double>(m, m, 1);
+    const DoubleMatrix db = randomMatrix<double>(m, m, 2);
+    DoubleMatrix dc;
+    runner.run("gemm/double/" + shapeName(m, m, m), { gemmFlops(m, m, m), 8. * 3 * m * m, 0. }, [&] {
+        DoubleMatrix::multiplyInto(dc, da, db);
+    });
+}
+
+// Element-wise and row-wise activations in each accuracy mode, in place over a 512x512 matrix.
+void benchmarkActivations(BenchmarkRunner& runner) {
+    const struct {
+        Activation activation;
+        const char* name;
+    } activations[] = {
+        { Activation::Sigmoid, "sigmoid" }, { Activation::Tanh, "tanh" }, { Activation::ReLU, "relu" },
+        { Activation::GELU, "gelu" }, { Activation::Softmax, "softmax" },
+    };
+    const struct {
+        ActivationAccuracy accuracy;
+        const char* name;
+    } accuracies[] = {
+        { ActivationAccuracy::Exact, "exact" }, { ActivationAccuracy::Fast, "fast" },
+        { ActivationAccuracy::UltraFast, "ultrafast" },
+    };
+
+    const int size = 512;
+    const Matrix input = randomMatrix<float>(size, size, 3);
+    Matrix output;
+    for (const auto& [accuracy, accuracyName] : accuracies) {
+        ActivationFunction::setAccuracy(accuracy);
+        for (const auto& [activation, activationName] : activations) {
+            runner.run(
+                std::string("activation/") + activationName + "/" + accuracyName,
+                { 0., 4. * 2 * size * size, static_cast<double>(size) * size },
+                [&] { ActivationFunction::applyInto(activation, output, input); }
+            );
+        }
+    }
+    ActivationFunction::setAccuracy(ActivationAccuracy::Exact);
+}
+
+// A 784 -> 128 ReLU layer, i.e. the first layer of an MNIST classifier, over a sweep of batch sizes.
+void benchmarkLayers(BenchmarkRunner& runner) {
+    const int inputSize = 784;
+    const int outputSize = 128;
+    Layer layer(inputSize, outputSize, Activation::ReLU);
+    Random random(4);
+    layer.randomize(-0.1f, 0.1f, random);
+
+    for (const int batch : { 1, 32, 256 }) {
+        const Matrix input = randomMatrix<float>(batch, inputSize, 5);
+        const double flops = gemmFlops(batch, outputSize, inputSize);
+        const double bytes = 4. * (batch * inputSize + inputSize * outputSize + batch * outputSize);
+        Matrix output;
+        runner.run(
+            "layer/forward/" + std::to_string(inputSize) + "x" + std::to_string(outputSize)
+                + "/batch" + std::to_string(batch),
+            { flops, bytes, static_cast<double>(batch) },
+            [&] { layer.forwardInto(input, output); }
+        );
+
+        // Forward pass plus the weight, bias and input gradients: three products of the same size.
+        Matrix outputGradients;
+        Matrix weightGradients;
+        Matrix biasGradients;
+        Matrix inputGradients;
+        runner.run(
+            "layer/backward/" + std::to_string(inputSize) + "x" + std::to_string(outputSize)
+                + "/batch" + std::to_string(batch),
+            { 3. * flops, 2. * bytes, static_cast<double>(batch) },
+            [&] {
+                outputGradients = layer.forwardTraining(input);
+                layer.backward(outputGradients, weightGradients, biasGradients, &inputGradients);
+            }
+        );
+    }
+}
+
+// `predict` throughput from a tiny network up to an MLP whose weights no longer fit in L2.
+void benchmarkPredict(BenchmarkRunner& runner) {
+    const std::vector<std::vector<int>> topologies = { { 2, 8, 1 }, { 784, 128, 10 }, { 256, 512, 512, 10 } };
+    for (const std::vector<int>& sizes : topologies) {
+        NeuralNetwork nn(sizes);
+        nn.randomize(-0.1f, 0.1f, Random(6));
+        for (const int batch : { 1, 64, 1024 }) {
+            const Matrix input = randomMatrix<float>(batch, sizes.front(), 7);
+            Matrix output;
+            runner.run(
+                "predict/" + topologyName(sizes) + "/batch" + std::to_string(batch),
+                { networkFlops(sizes, batch), 0., static_cast<double>(batch) },
+                [&] { nn.predict(input, output); }
+            );
+        }
+    }
+}
+
+// One epoch per iteration over 4096 synthetic samples, without logging; items are samples, so items/s is
+// training throughput.
+void benchmarkTraining(BenchmarkRunner& runner) {
+    TrainingOptions options;
+    options.epochs = 1;
+    options.learningRate = 0.01f;
+    options.logInterval = 0;
+
+    const std::vector<int> sizes = { 64, 128, 10 };
+    const int samples = 4096;
+    const Matrix inputs = randomMatrix<float>(samples, sizes.front(), 8);
+    Matrix targets = randomMatrix<float>(samples, sizes.back(), 9);
+    for (float& value : targets.span()) {
+        value = value > 0.f ? 1.f : 0.f;
+    }
+
+    for (const int batch : { 32, 256 }) {
+        NeuralNetwork nn(sizes);
+        nn.randomize(-0.1f, 0.1f, Random(10));
+        options.batchSize = batch;
+        runner.run(
+            "train/backprop-adam/" + topologyName(sizes) + "/batch" + std::to_string(batch),
+            { 3. * networkFlops(sizes, samples), 0., static_cast<double>(samples) },
+            [&] { (void) nn.train(inputs, targets, options); }
+        );
+    }
+
+    const std::vector<int> small = { 8, 16, 2 };
+    const Matrix geneticInputs = randomMatrix<float>(256, small.front(), 11);
+    const Matrix geneticTargets = randomMatrix<float>(256, small.back(), 12);
+    NeuralNetwork nn(small);
+    nn.randomize(-1.f, 1.f, Random(13));
+    options.mode = TrainingMode::Genetic;
+    runner.run(
+        "train/genetic/" + topologyName(small) + "/samples256",
+        { 0., 0., 256. },
+        [&] { (void) nn.train(geneticInputs, geneticTargets, options); }
+    );
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    std::string jsonPath;
+    std::string baselinePath;
+    double maxRegression = -1.;
+    bool list = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            const auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("missing value for " + argument);
+                }
+                return argv[++i];
+            };
+            if (argument == "--filter") {
+                options.filter = value();
+            } else if (argument == "--json") {
+                jsonPath = value();
+            } else if (argument == "--baseline") {
+                baselinePath = value();
+            } else if (argument == "--max-regression") {
+                maxRegression = std::stod(value());
+            } else if (argument == "--repetitions") {
+                options.repetitions = std::stoi(value());
+            } else if (argument == "--warmup") {
+                options.warmupIterations = std::stoi(value());
+            } else if (argument == "--min-sample-time") {
+                options.minSampleSeconds = std::stod(value());
+            } else if (argument == "--threads") {
+                ThreadPool::setThreadCount(std::stoi(value()));
+            } else if (argument == "--list") {
+                list = true;
+            } else {
+                std::cout << USAGE;
+                return argument == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+        options.dryRun = list;
+
+        BenchmarkRunner runner(options);
+        benchmarkGemm(runner);
+        benchmarkActivations(runner);
+        benchmarkLayers(runner);
+        benchmarkPredict(runner);
+        benchmarkTraining(runner);
+
+        if (list) {
+            for (const BenchmarkResult& result : runner.getResults()) {
+                std::cout << result.name << '\n';
+            }
+            return EXIT_SUCCESS;
+        }
+
+        runner.printTable(std::cout);
+        if (!jsonPath.empty()) {
+            runner.writeJson(jsonPath, {
+                { "kernel", Gemm::kernelName(Gemm::activeKernel()) },
+                { "threads", std::to_string(ThreadPool::getThreadCount()) },
+#ifdef NDEBUG
+                { "assertions", "off" },
+#else
+                { "assertions", "on" },
+#endif
+                { "compiler", __VERSION__ },
+            });
+        }
+        if (!baselinePath.empty()) {
+            std::cout << '\n';
+            const double worst = runner.compare(baselinePath, std::cout);
+            if (maxRegression >= 0. && worst > maxRegression) {
+                std::cout << "regression above " << maxRegression << "%\n";
+                return 2;
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "nnn_bench: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
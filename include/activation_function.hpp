@@ -4,11 +4,69 @@
 
 namespace nnn {
 
-class ActivationFunction {
+enum class Activation {
+    Sigmoid,
+    Tanh,
+    ReLU,
+    LeakyReLU,
+    GELU,
+    Softmax,
+};
+
+// Accuracy of the exp-based activations (sigmoid, tanh, GELU, softmax). ReLU variants are exact in every mode.
+// Maximum absolute errors against the Exact results over [-20; 20]:
+//   Exact     - libm `std::exp`/`std::tanh`/`std::erf`, scalar
+//   Fast      - SIMD, 6th order polynomial exp (~2 ulp): sigmoid/tanh 1.2e-7, GELU 5e-7, softmax 3e-7
+//   UltraFast - SIMD, cubic exp (7.5e-5 relative): sigmoid 2e-5, tanh 4e-5, GELU 5e-4 (tanh form), softmax 1.5e-4
+enum class ActivationAccuracy {
+    Exact,
+    Fast,
+    UltraFast,
+};
+
+// Activations over `BasicMatrix<T>`; `ActivationFunction` is the float instantiation. The accuracy mode is shared
+// by all scalar types, but only float has SIMD kernels: other types always use the exact scalar ones.
+template<typename T>
+class BasicActivationFunction {
 public:
+    using Matrix = BasicMatrix<T>;
+    // Transforms `count` contiguous values in place; the signature of a GEMM epilogue activation.
+    using Kernel = void (*)(T* values, int count);
+
+    static constexpr T LEAKY_RELU_SLOPE = T(0.01);
+
     static Matrix sigmoid(const Matrix& x);
+    static Matrix tanh(const Matrix& x);
+    static Matrix relu(const Matrix& x);
+    static Matrix leakyRelu(const Matrix& x);
+    static Matrix gelu(const Matrix& x);
+    // Row-wise softmax.
+    static Matrix softmax(const Matrix& x);
+    static Matrix apply(Activation activation, const Matrix& x);
+
+    // Destination-passing variants: `out` is resized to the shape of `x` (reusing its buffer) and may be `x` itself.
+    static void sigmoidInto(Matrix& out, const Matrix& x);
+    static void applyInto(Activation activation, Matrix& out, const Matrix& x);
+
+    // Applies `activation` to `count` contiguous values in place; for softmax they are treated as one row.
+    static void applyInPlace(Activation activation, T* values, int count);
+    // In-place kernel for the current accuracy mode; softmax normalizes each call's values as one row.
+    static Kernel kernel(Activation activation);
+    // Backward pass over `count` contiguous values: turns `gradients` with respect to the outputs into gradients
+    // with respect to the inputs, given the `inputs` and `outputs` of the forward pass. Exact derivatives in every
+    // accuracy mode; softmax treats the values as one row.
+    static void backwardInPlace(Activation activation, const T* inputs, const T* outputs, T* gradients, int count);
+
+    // Global accuracy mode; `Exact` by default.
+    static void setAccuracy(ActivationAccuracy accuracy);
+    static ActivationAccuracy getAccuracy();
 };
 
+using ActivationFunction = BasicActivationFunction<float>;
+
+extern template class BasicActivationFunction<float>;
+extern template class BasicActivationFunction<double>;
+
 } // nnn
 
 #endif //ACTIVATION_FUNCTION_HPP
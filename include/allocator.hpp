@@ -0,0 +1,123 @@
+#ifndef ALLOCATOR_HPP
+#define ALLOCATOR_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace nnn {
+
+// Every buffer handed out by an allocator is aligned to this many bytes.
+constexpr std::size_t MATRIX_ALIGNMENT = 64;
+
+struct AllocationStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytesAllocated = 0;
+    // Requests served from recycled memory, and requests that had to go to the system allocator.
+    std::uint64_t poolHits = 0;
+    std::uint64_t systemAllocations = 0;
+};
+
+// Source of Matrix storage. A Matrix remembers which allocator produced its buffer and returns it there,
+// so allocators can be swapped at any time without affecting live matrices.
+class MatrixAllocator {
+public:
+    MatrixAllocator() = default;
+    MatrixAllocator(const MatrixAllocator&) = delete;
+    MatrixAllocator& operator=(const MatrixAllocator&) = delete;
+    virtual ~MatrixAllocator() = default;
+
+    // Returns storage for `count` floats; `deallocate` receives the same `count`.
+    virtual float* allocate(std::size_t count) = 0;
+    virtual void deallocate(float* pointer, std::size_t count) = 0;
+    [[nodiscard]] virtual AllocationStats stats() const = 0;
+
+    // Allocator used for new matrices on this thread: the innermost ArenaScope if any, else the default.
+    static MatrixAllocator& current();
+    // Process-wide default, initially the pool. Passing nullptr restores the pool.
+    static void setDefault(MatrixAllocator* allocator);
+    static MatrixAllocator& getDefault();
+    static MatrixAllocator& pool();
+    static MatrixAllocator& system();
+};
+
+// Thin wrapper over aligned operator new/delete.
+class SystemAllocator final : public MatrixAllocator {
+public:
+    float* allocate(std::size_t count) override;
+    void deallocate(float* pointer, std::size_t count) override;
+    [[nodiscard]] AllocationStats stats() const override;
+
+private:
+    std::atomic<std::uint64_t> allocations{ 0 };
+    std::atomic<std::uint64_t> deallocations{ 0 };
+    std::atomic<std::uint64_t> bytesAllocated{ 0 };
+};
+
+// Power-of-two size classes with per-thread free lists in front of a shared, mutex-protected free list.
+// Freed blocks are kept for reuse; `trim` gives the shared ones back to the system.
+class PoolAllocator final : public MatrixAllocator {
+public:
+    // Size classes hold 16 << c floats, for c in [0, CLASS_COUNT); bigger requests bypass the pool.
+    static constexpr int CLASS_COUNT = 20;
+    // Blocks a thread keeps per size class before handing half of them to the shared list.
+    static constexpr std::size_t THREAD_CACHE_LIMIT = 32;
+
+    PoolAllocator();
+    ~PoolAllocator() override;
+
+    float* allocate(std::size_t count) override;
+    void deallocate(float* pointer, std::size_t count) override;
+    [[nodiscard]] AllocationStats stats() const override;
+    void trim();
+
+private:
+    struct ThreadCache;
+    friend struct ThreadCache;
+
+    static int sizeClass(std::size_t count);
+    ThreadCache& threadCache();
+    void returnBlocks(int sizeClass, std::vector<float*>& blocks, std::size_t keep);
+
+    const std::uint64_t id;
+    std::mutex mutex;
+    std::vector<float*> shared[CLASS_COUNT];
+    std::atomic<std::uint64_t> allocations{ 0 };
+    std::atomic<std::uint64_t> deallocations{ 0 };
+    std::atomic<std::uint64_t> bytesAllocated{ 0 };
+    std::atomic<std::uint64_t> poolHits{ 0 };
+    std::atomic<std::uint64_t> systemAllocations{ 0 };
+};
+
+// Bump allocator active on the creating thread for its lifetime: matrices created inside the scope take
+// their storage from a few large blocks that are released all at once when the scope ends. Deallocation
+// is free. Every matrix allocated inside the scope must be destroyed before the scope ends.
+class ArenaScope final : public MatrixAllocator {
+public:
+    explicit ArenaScope(std::size_t blockBytes = 1 << 20);
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+    ~ArenaScope() override;
+
+    float* allocate(std::size_t count) override;
+    void deallocate(float* pointer, std::size_t count) override;
+    [[nodiscard]] AllocationStats stats() const override;
+
+private:
+    struct Block {
+        float* data;
+        std::size_t size;
+    };
+
+    std::size_t blockSize;
+    std::vector<Block> blocks;
+    std::size_t used = 0;
+    MatrixAllocator* previous;
+    AllocationStats counters;
+};
+
+} // nnn
+
+#endif //ALLOCATOR_HPP
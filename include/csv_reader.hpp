@@ -0,0 +1,41 @@
+#ifndef CSV_READER_HPP
+#define CSV_READER_HPP
+#include "matrix.hpp"
+#include <string>
+
+namespace nnn {
+
+struct CsvOptions {
+    char delimiter = ',';
+    // Skips the first line.
+    bool header = false;
+};
+
+// Reader for numeric delimited text: one sample per line, every field a float. Fields may be surrounded by
+// spaces, lines may end in "\r\n", and blank lines are skipped; quoting is not supported. The file is
+// memory-mapped and split into chunks at line boundaries that are parsed with `std::from_chars` on the
+// thread pool, straight into the destination rows. Malformed input throws `std::runtime_error` naming the
+// first offending line (1-based, counting the header and blank lines) and column.
+class CsvReader {
+public:
+    CsvReader() = delete;
+    CsvReader(const CsvReader&) = delete;
+    CsvReader(CsvReader&&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+    CsvReader& operator=(CsvReader&&) = delete;
+
+    // Chunks are at least this many bytes, so small files are parsed on the calling thread.
+    static constexpr int CHUNK_BYTES = 1 << 16;
+
+    // Reads the file into a new matrix, with as many columns as the first line has fields.
+    [[nodiscard]] static Matrix read(const std::string& path, const CsvOptions& options = {});
+    // Reads the file into `out`, which may be a view; the file must have exactly its shape.
+    static void readInto(Matrix& out, const std::string& path, const CsvOptions& options = {});
+    // Reads the first `inputs.getCols()` fields of every line into `inputs` and the remaining ones into
+    // `targets`; both must already have one row per line.
+    static void readInto(Matrix& inputs, Matrix& targets, const std::string& path, const CsvOptions& options = {});
+};
+
+} // nnn
+
+#endif //CSV_READER_HPP
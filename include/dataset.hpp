@@ -0,0 +1,94 @@
+#ifndef DATASET_HPP
+#define DATASET_HPP
+#include <condition_variable>
+#include <cstdint>
+#include "mapped_file.hpp"
+#include "matrix.hpp"
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nnn {
+
+// Binary dataset file: a 64-byte header, then the inputs and the targets as two row-major float blocks.
+// Each block starts on a 64-byte boundary and pads its rows to `Matrix::strideFor` strides, so mapped rows
+// are usable as Matrix views as they are. Values are stored in the host's byte order.
+struct DatasetHeader {
+    static constexpr char MAGIC[8] = { 'N', 'N', 'N', 'D', 'A', 'T', 'A', '\0' };
+    static constexpr std::uint32_t VERSION = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t inputSize;
+    std::uint32_t outputSize;
+    std::uint32_t inputStride;
+    std::uint32_t outputStride;
+    std::uint32_t reserved;
+    std::uint64_t rows;
+    std::uint64_t inputOffset;
+    std::uint64_t outputOffset;
+    std::uint64_t padding;
+};
+static_assert(sizeof(DatasetHeader) == 64);
+
+// Memory-mapped dataset. Row ranges come out as Matrix views into the mapping, so nothing is read until it
+// is used and nothing is copied; writes through a view stay private to the process.
+class Dataset {
+public:
+    explicit Dataset(const std::string& path);
+
+    // Writes `inputs` and `targets` (one row per sample) in the dataset format.
+    static void save(const std::string& path, const Matrix& inputs, const Matrix& targets);
+
+    [[nodiscard]] int getRows() const;
+    [[nodiscard]] int getInputSize() const;
+    [[nodiscard]] int getOutputSize() const;
+
+    // Views of rows [begin, end).
+    [[nodiscard]] Matrix inputs(int begin, int end) const;
+    [[nodiscard]] Matrix targets(int begin, int end) const;
+
+    // Faults in the pages of rows [begin, end) of both blocks.
+    void prefetch(int begin, int end) const;
+
+private:
+    [[nodiscard]] Matrix block(std::uint64_t offset, int cols, int stride, int begin, int end) const;
+
+    MappedFile file;
+    DatasetHeader header{};
+};
+
+// Walks a dataset in mini-batches of consecutive rows, as views into the mapping. While the caller works
+// on one batch, a background thread prefetches the next one.
+class BatchLoader {
+public:
+    BatchLoader(const Dataset& dataset, int batchSize);
+    BatchLoader(const BatchLoader&) = delete;
+    BatchLoader& operator=(const BatchLoader&) = delete;
+    ~BatchLoader();
+
+    // Points `inputs` and `targets` at the next batch; the last batch of an epoch may be smaller. Returns
+    // false, and rewinds to the first batch, once the epoch is over.
+    bool next(Matrix& inputs, Matrix& targets);
+    // Rewinds to the first batch.
+    void reset();
+
+private:
+    void requestPrefetch(int begin);
+    void prefetchLoop();
+
+    const Dataset& dataset;
+    int batchSize;
+    int position = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    // First row of the batch to prefetch, or -1 when there is nothing to do.
+    int pending = -1;
+    bool stopping = false;
+    std::thread prefetcher;
+};
+
+} // nnn
+
+#endif //DATASET_HPP
@@ -0,0 +1,105 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+#include <cstddef>
+
+namespace nnn {
+
+// Micro-kernel families the GEMM engine can dispatch to.
+enum class GemmKernel {
+    Auto,
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+// Whether a GEMM operand is used as stored or transposed.
+enum class Transpose {
+    No,
+    Yes,
+};
+
+// Work fused into the GEMM: applied to each output tile right after its accumulation over K completes,
+// while the tile is still hot in cache. `bias` (length n) is broadcast over rows, then `activation`
+// transforms a run of `count` contiguous outputs in place.
+template<typename T>
+struct BasicGemmEpilogue {
+    const T* bias = nullptr;
+    void (*activation)(T* values, int count) = nullptr;
+};
+
+using GemmEpilogue = BasicGemmEpilogue<float>;
+
+// The float overloads run the packed, cache-blocked engine with hand-written micro-kernels. Other element
+// types run a portable kernel whose register tile is `ScalarTraits<T>::SIMD_WIDTH` columns wide, which the
+// compiler vectorizes at that type's width; transposed operands are packed first.
+class Gemm {
+public:
+    Gemm() = delete;
+    Gemm(const Gemm&) = delete;
+    Gemm(Gemm&&) = delete;
+    Gemm& operator=(const Gemm&) = delete;
+    Gemm& operator=(Gemm&&) = delete;
+
+    // C = A * B, where A is m x k, B is k x n and C is m x n, all row-major with given leading dimensions.
+    static void multiply(int m, int n, int k, const float* a, int lda, const float* b, int ldb, float* c, int ldc);
+    // C = epilogue(A * B).
+    static void multiply(
+        int m, int n, int k,
+        const float* a, int lda,
+        const float* b, int ldb,
+        float* c, int ldc,
+        const GemmEpilogue& epilogue
+    );
+    // C = epilogue(op(A) * op(B)), where op(A) is m x k and op(B) is k x n. A transposed operand is read in place
+    // from its row-major storage: with `transposeA == Transpose::Yes`, A is stored as k x m with leading
+    // dimension `lda` (likewise B as n x k).
+    static void multiply(
+        Transpose transposeA, Transpose transposeB,
+        int m, int n, int k,
+        const float* a, int lda,
+        const float* b, int ldb,
+        float* c, int ldc,
+        const GemmEpilogue& epilogue = {}
+    );
+    // Strided-batched product: C_i = epilogue_i(A_i * B_i) for i in [0, batch), where A_i starts at
+    // `a + i * strideA` (likewise B_i and C_i) and epilogue_i uses the bias at `epilogue.bias + i * strideBias`.
+    // Strides may be 0 to share an operand. Entries run in parallel, each as one `multiply`.
+    static void multiplyBatched(
+        int batch, int m, int n, int k,
+        const float* a, int lda, std::ptrdiff_t strideA,
+        const float* b, int ldb, std::ptrdiff_t strideB,
+        float* c, int ldc, std::ptrdiff_t strideC,
+        const GemmEpilogue& epilogue, std::ptrdiff_t strideBias
+    );
+
+    // B = A^T for a rows x cols matrix A, in cache-sized tiles spread over the thread pool. A and B must not overlap.
+    static void transpose(int rows, int cols, const float* a, int lda, float* b, int ldb);
+
+    // Double precision, with the portable kernel.
+    static void multiply(int m, int n, int k, const double* a, int lda, const double* b, int ldb, double* c, int ldc);
+    static void multiply(
+        int m, int n, int k,
+        const double* a, int lda,
+        const double* b, int ldb,
+        double* c, int ldc,
+        const BasicGemmEpilogue<double>& epilogue
+    );
+    static void multiply(
+        Transpose transposeA, Transpose transposeB,
+        int m, int n, int k,
+        const double* a, int lda,
+        const double* b, int ldb,
+        double* c, int ldc,
+        const BasicGemmEpilogue<double>& epilogue = {}
+    );
+    static void transpose(int rows, int cols, const double* a, int lda, double* b, int ldb);
+
+    // Forces a specific micro-kernel; returns false if the CPU does not support it. `Auto` restores detection.
+    static bool setKernel(GemmKernel kernel);
+    static GemmKernel activeKernel();
+    static const char* kernelName(GemmKernel kernel);
+};
+
+} // nnn
+
+#endif //GEMM_HPP
@@ -1,24 +1,58 @@
 #ifndef LAYER_HPP
 #define LAYER_HPP
+#include "activation_function.hpp"
 #include "matrix.hpp"
+#include "random.hpp"
 
 namespace nnn {
 
-class Layer {
+// A standalone layer owns its weights and biases. Inside a NeuralNetwork they are views into the network's
+// parameter buffer instead; copying such a layer yields a standalone one, while assigning a same-shaped layer
+// to it writes through into the network (a differently shaped one throws). `Layer` is the float instantiation;
+// NeuralNetwork is built from it.
+template<typename T>
+class BasicLayer {
 public:
-    Layer();
-    Layer(int inputSize, int outputSize);
-    Layer(const Layer& other);
-    Layer(Layer&& other) noexcept;
-    Layer& operator=(const Layer& other);
-    Layer& operator=(Layer&& other) noexcept;
+    using Matrix = BasicMatrix<T>;
+
+    BasicLayer();
+    BasicLayer(int inputSize, int outputSize, Activation activation = Activation::Sigmoid);
+    BasicLayer(Matrix weights, Matrix biases, Activation activation);
+    BasicLayer(const BasicLayer& other);
+    BasicLayer(BasicLayer&& other) noexcept;
+    BasicLayer& operator=(const BasicLayer& other);
+    BasicLayer& operator=(BasicLayer&& other);
     [[nodiscard]] Matrix forward(const Matrix& input) const;
-    void randomize(float low, float high);
+    // Writes the layer output into `output`, reusing its buffer when it is large enough.
+    // `output` must not be `input`.
+    void forwardInto(const Matrix& input, Matrix& output) const;
+    void randomize(T low, T high);
+    void randomize(T low, T high, Random& random);
+
+    // Training forward pass: like `forwardInto`, but caches what `backward` needs. Returns the output, which
+    // stays valid until the next call. `input` must stay alive and unchanged until `backward` has run.
+    const Matrix& forwardTraining(const Matrix& input);
+    // Backpropagates through the last `forwardTraining` call. `outputGradients` holds dL/d(output) and is
+    // overwritten with dL/d(pre-activation). Writes dL/dW and dL/db into `weightGradients` and `biasGradients`
+    // (shaped like `weights` and `biases`), and dL/d(input) into `inputGradients` unless it is null.
+    void backward(Matrix& outputGradients, Matrix& weightGradients, Matrix& biasGradients, Matrix* inputGradients);
 
     Matrix weights;
     Matrix biases;
+    Activation activation = Activation::Sigmoid;
+
+private:
+    // Cache of the last `forwardTraining` call; never copied.
+    const Matrix* cachedInput = nullptr;
+    Matrix preActivations;
+    Matrix outputs;
 };
 
+using Layer = BasicLayer<float>;
+
+extern template class BasicLayer<float>;
+extern template class BasicLayer<double>;
+
 } // nnn
 
 #endif //LAYER_HPP
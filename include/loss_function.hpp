@@ -4,17 +4,28 @@
 
 namespace nnn {
 
-class LossFunction {
+// Losses over `BasicMatrix<T>`; `LossFunction` is the float instantiation.
+template<typename T>
+class BasicLossFunction {
 public:
-    LossFunction() = delete;
-    LossFunction(const LossFunction&) = delete;
-    LossFunction(LossFunction&&) = delete;
-    LossFunction& operator=(const LossFunction&) = delete;
-    LossFunction& operator=(LossFunction&&) = delete;
+    using Matrix = BasicMatrix<T>;
 
-    static float meanSquaredError(const Matrix& predictions, const Matrix& targets);
+    BasicLossFunction() = delete;
+    BasicLossFunction(const BasicLossFunction&) = delete;
+    BasicLossFunction(BasicLossFunction&&) = delete;
+    BasicLossFunction& operator=(const BasicLossFunction&) = delete;
+    BasicLossFunction& operator=(BasicLossFunction&&) = delete;
+
+    static T meanSquaredError(const Matrix& predictions, const Matrix& targets);
+    // Gradient of `meanSquaredError` with respect to `predictions`, written to `gradients` (resized to match).
+    static void meanSquaredErrorGradient(const Matrix& predictions, const Matrix& targets, Matrix& gradients);
 };
 
+using LossFunction = BasicLossFunction<float>;
+
+extern template class BasicLossFunction<float>;
+extern template class BasicLossFunction<double>;
+
 }
 
 #endif //LOSS_FUNCTION_HPP
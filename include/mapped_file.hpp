@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+#include <cstddef>
+#include <string>
+
+namespace nnn {
+
+// Read-only file mapped into memory. The mapping is private: pages are shared with the page cache (and with
+// other processes mapping the same file) until written to, and writes never reach the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    [[nodiscard]] std::byte* data();
+    [[nodiscard]] const std::byte* data() const;
+    [[nodiscard]] std::size_t size() const;
+
+    // Asks the kernel to read [offset, offset + count) ahead, then faults it in, so that later accesses
+    // do not block on I/O. Safe to call from another thread while the mapping is read.
+    void prefetch(std::size_t offset, std::size_t count) const;
+
+private:
+    void unmap();
+
+    std::byte* bytes = nullptr;
+    std::size_t length = 0;
+};
+
+} // nnn
+
+#endif //MAPPED_FILE_HPP
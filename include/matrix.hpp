@@ -1,44 +1,351 @@
 #ifndef MATRIX_HPP
 #define MATRIX_HPP
+#include <concepts>
+#include <cstddef>
+#include "gemm.hpp"
+#include "matrix_expression.hpp"
 #include <memory>
+#include "scalar_traits.hpp"
+#include <span>
+#include <stdexcept>
+#include "thread_pool.hpp"
 #include <vector>
 
 namespace nnn {
 
-class Matrix {
+class MatrixAllocator;
+class Random;
+
+// Dense matrix of `T` elements; `Matrix` is the float instantiation used throughout the library, and float and
+// double are instantiated in matrix.cpp (see scalar_traits.hpp for adding types).
+// Storage comes from `MatrixAllocator::current()` (a pooled allocator by default) and is 64-byte aligned.
+// Rows of wide matrices are padded so that each one starts on a cache line (see `getStride`); the padding
+// is not part of the matrix and is never visible through `getRows`, `getCols` or element access.
+// `+`, `-`, scalar `*`, `elementwiseMultiply` and `transposed` are lazy (see matrix_expression.hpp);
+// matrix multiplication is evaluated eagerly by the GEMM engine.
+template<typename T>
+class BasicMatrix : public MatrixExpression<BasicMatrix<T>> {
 public:
-    Matrix();
-    Matrix(int rows, int cols);
-    Matrix(int rows, int cols, const std::vector<float>& values);
-    Matrix(const Matrix& other);
-    Matrix(Matrix&& other) noexcept;
-
-    Matrix& operator=(const Matrix& other);
-    Matrix& operator=(Matrix&& other) noexcept;
-    Matrix operator+(const Matrix& other) const;
-    Matrix& operator+=(const Matrix& other);
-    Matrix operator-(const Matrix& other) const;
-    Matrix& operator-=(const Matrix& other);
-    Matrix operator*(const Matrix& other) const;
-    Matrix operator*(float scalar) const;
-    float operator()(int row, int col) const;
-    float& operator()(int row, int col);
+    using Scalar = T;
+
+    BasicMatrix();
+    BasicMatrix(int rows, int cols);
+    BasicMatrix(int rows, int cols, const std::vector<T>& values);
+    BasicMatrix(const BasicMatrix& other);
+    BasicMatrix(BasicMatrix&& other) noexcept;
+    template<typename E>
+        requires std::same_as<typename E::Scalar, T>
+    BasicMatrix(const MatrixExpression<E>& expression);
+    ~BasicMatrix();
+
+    BasicMatrix& operator=(const BasicMatrix& other);
+    BasicMatrix& operator=(BasicMatrix&& other);
+    template<typename E>
+    BasicMatrix& operator=(const MatrixExpression<E>& expression);
+    BasicMatrix& operator+=(const BasicMatrix& other);
+    template<typename E>
+    BasicMatrix& operator+=(const MatrixExpression<E>& expression);
+    BasicMatrix& operator-=(const BasicMatrix& other);
+    template<typename E>
+    BasicMatrix& operator-=(const MatrixExpression<E>& expression);
+    BasicMatrix operator*(const BasicMatrix& other) const;
+    T operator()(int row, int col) const;
+    T& operator()(int row, int col);
 
     [[nodiscard]] int getRows() const;
     [[nodiscard]] int getCols() const;
-    [[nodiscard]] Matrix transposed() const;
-    [[nodiscard]] Matrix elementwiseMultiply(const Matrix& other) const;
+    // Leading dimension: distance in elements between the starts of consecutive rows, `>= getCols()`.
+    [[nodiscard]] int getStride() const;
+
+    // Elements per 64-byte cache line; padded strides are a multiple of this.
+    static constexpr int STRIDE_ALIGNMENT = ScalarTraits<T>::SIMD_WIDTH;
+    // Matrices with fewer columns stay dense, where padding would cost more than misaligned rows.
+    static constexpr int PADDING_THRESHOLD = 64;
+    // Stride used for matrices with `cols` columns.
+    [[nodiscard]] static int strideFor(int cols);
+
+    // Expression leaf interface.
+    [[nodiscard]] T coeff(int row, int col) const;
+    [[nodiscard]] bool references(const BasicMatrix& matrix) const;
+    static constexpr bool ELEMENT_LOCAL = true;
+
+    // Unchecked access to the row-major storage, for kernels that walk whole rows or buffers. Row `i` starts
+    // at `data() + i * getStride()`; `span()` covers all `getRows() * getStride()` elements, padding included,
+    // so it only suits operations that are indifferent to the padding values (fill, copy, element-wise maps).
+    [[nodiscard]] T* data();
+    [[nodiscard]] const T* data() const;
+    [[nodiscard]] T* rowData(int row);
+    [[nodiscard]] const T* rowData(int row) const;
+    [[nodiscard]] std::span<T> span();
+    [[nodiscard]] std::span<const T> span() const;
+    [[nodiscard]] std::span<T> rowSpan(int row);
+    [[nodiscard]] std::span<const T> rowSpan(int row) const;
 
-    void fill(float value);
-    void randomize(float low, float high);
+    // Destination-passing variants of the operators: `out` is resized to the result shape, reusing its buffer
+    // when it is large enough. `out` may alias an operand of `addInto`, but not of `multiplyInto`.
+    static void multiplyInto(BasicMatrix& out, const BasicMatrix& a, const BasicMatrix& b);
+    // `out = op(a) * op(b)`, reading transposed operands in place instead of materializing them.
+    static void multiplyInto(
+        BasicMatrix& out, const BasicMatrix& a, Transpose transposeA, const BasicMatrix& b, Transpose transposeB
+    );
+    // `out = a^T` with a cache-blocked transpose; `out` must not be `a`.
+    static void transposeInto(BasicMatrix& out, const BasicMatrix& a);
+    static void addInto(BasicMatrix& out, const BasicMatrix& a, const BasicMatrix& b);
+
+    // Non-owning matrix over `rows` rows of `cols` elements starting `stride` elements apart. `data` must outlive
+    // the view. Copies of a view own their storage.
+    // A view keeps its shape: assigning (or moving) a matrix to it, or passing it as the output of an `...Into`
+    // function, writes the elements through into `data`, and throws if the shape differs. Use `rebind` or
+    // `reset` to point the variable elsewhere.
+    [[nodiscard]] static BasicMatrix view(T* data, int rows, int cols, int stride);
+    [[nodiscard]] bool isView() const;
+    // Replaces this matrix, view or not, with `other`, also view or not, without writing through.
+    void rebind(BasicMatrix&& other) noexcept;
+    // Releases the storage, or drops the view, leaving an empty matrix.
+    void reset() noexcept;
+    // Whether the stride is `strideFor(getCols())`, so that rows and their padding form one contiguous run.
+    // Only views made with another stride lack it.
+    [[nodiscard]] bool hasPaddedLayout() const;
+
+    // Changes the shape, reallocating only when the current buffer is too small. Contents are unspecified unless
+    // the shape is unchanged. Throws for a view whose shape would change.
+    void resize(int rows, int cols);
+    void fill(T value);
+    // Uniform values in [low, high), from `random` or from a fresh stream of the global generator.
+    void randomize(T low, T high);
+    void randomize(T low, T high, Random& random);
     void print() const;
 
 private:
+    struct Uninitialized {};
+    BasicMatrix(int rows, int cols, Uninitialized);
+
+    template<typename E>
+    void evaluate(const E& expression);
+    void evaluate(const TransposeExpression<BasicMatrix>& expression);
+    void acquire(std::size_t count);
+    void release();
+    void clearPadding();
+    void take(BasicMatrix& other) noexcept;
+    [[nodiscard]] bool sharesLayout(const BasicMatrix& other) const;
+    void copyFrom(const BasicMatrix& other);
+
+    [[noreturn]] static void throwOutOfRange(bool badRow);
+
     int rows;
     int cols;
-    std::unique_ptr<float[]> data;
+    T* values;
+    std::size_t capacity;
+    MatrixAllocator* allocator;
+    int stride;
 };
 
+using Matrix = BasicMatrix<float>;
+using DoubleMatrix = BasicMatrix<double>;
+
+extern template class BasicMatrix<float>;
+extern template class BasicMatrix<double>;
+
+// Element access is defined inline so that loops over `operator()` can be optimized.
+// Building with NNN_UNCHECKED_ACCESS (see the NNN_CHECKED_ACCESS CMake option) drops the bounds checks.
+template<typename T>
+inline T BasicMatrix<T>::operator()(int row, int col) const {
+#ifndef NNN_UNCHECKED_ACCESS
+    if (row < 0 || row >= rows || col < 0 || col >= cols) {
+        throwOutOfRange(row < 0 || row >= rows);
+    }
+#endif
+    return values[row * stride + col];
+}
+
+template<typename T>
+inline T& BasicMatrix<T>::operator()(int row, int col) {
+#ifndef NNN_UNCHECKED_ACCESS
+    if (row < 0 || row >= rows || col < 0 || col >= cols) {
+        throwOutOfRange(row < 0 || row >= rows);
+    }
+#endif
+    return values[row * stride + col];
+}
+
+template<typename T>
+inline T BasicMatrix<T>::coeff(int row, int col) const {
+    return values[row * stride + col];
+}
+
+template<typename T>
+inline bool BasicMatrix<T>::references(const BasicMatrix& matrix) const {
+    return this == &matrix;
+}
+
+template<typename T>
+inline T* BasicMatrix<T>::data() {
+    return values;
+}
+
+template<typename T>
+inline const T* BasicMatrix<T>::data() const {
+    return values;
+}
+
+template<typename T>
+inline T* BasicMatrix<T>::rowData(int row) {
+    return values + static_cast<std::ptrdiff_t>(row) * stride;
+}
+
+template<typename T>
+inline const T* BasicMatrix<T>::rowData(int row) const {
+    return values + static_cast<std::ptrdiff_t>(row) * stride;
+}
+
+template<typename T>
+inline std::span<T> BasicMatrix<T>::span() {
+    return { values, static_cast<std::size_t>(rows) * stride };
+}
+
+template<typename T>
+inline std::span<const T> BasicMatrix<T>::span() const {
+    return { values, static_cast<std::size_t>(rows) * stride };
+}
+
+template<typename T>
+inline std::span<T> BasicMatrix<T>::rowSpan(int row) {
+    return { rowData(row), static_cast<std::size_t>(cols) };
+}
+
+template<typename T>
+inline std::span<const T> BasicMatrix<T>::rowSpan(int row) const {
+    return { rowData(row), static_cast<std::size_t>(cols) };
+}
+
+// Element-wise loops below split rows across the thread pool; every element is still computed by the same
+// expression, so the result does not depend on the thread count.
+template<typename T>
+template<typename E>
+void BasicMatrix<T>::evaluate(const E& expression) {
+    ThreadPool::parallelForRows(rows, cols, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            T* out = rowData(i);
+            for (int j = 0; j < cols; ++j) {
+                out[j] = expression.coeff(i, j);
+            }
+        }
+    });
+}
+
+template<typename T>
+template<typename E>
+    requires std::same_as<typename E::Scalar, T>
+BasicMatrix<T>::BasicMatrix(const MatrixExpression<E>& expression)
+    : BasicMatrix(expression.getRows(), expression.getCols(), Uninitialized{}) {
+    evaluate(expression.self());
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpression<E>& expression) {
+    const E& source = expression.self();
+    if (!source.references(*this)) {
+        resize(source.getRows(), source.getCols());
+        evaluate(source);
+    } else if (rows == source.getRows() && cols == source.getCols() && E::ELEMENT_LOCAL) {
+        evaluate(source);
+    } else {
+        *this = BasicMatrix(source);
+    }
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const MatrixExpression<E>& expression) {
+    const E& source = expression.self();
+    if (cols != source.getCols()) {
+        throw std::runtime_error("Matrix::operator+=: matrix columns do not match");
+    }
+    if (rows < source.getRows()) {
+        throw std::runtime_error(
+            "Matrix::operator+=: Left hand-side rows should be greater or equal than right hand-side rows"
+        );
+    }
+    if (!E::ELEMENT_LOCAL && source.references(*this)) {
+        return *this += BasicMatrix(source);
+    }
+
+    const int sourceRows = source.getRows();
+    ThreadPool::parallelForRows(rows, cols, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            T* out = rowData(i);
+            for (int j = 0; j < cols; ++j) {
+                out[j] += source.coeff(i % sourceRows, j);
+            }
+        }
+    });
+    return *this;
+}
+
+template<typename T>
+template<typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const MatrixExpression<E>& expression) {
+    const E& source = expression.self();
+    if (rows != source.getRows() || cols != source.getCols()) {
+        throw std::runtime_error("Matrix::operator-=: matrix dimensions do not match");
+    }
+    if (!E::ELEMENT_LOCAL && source.references(*this)) {
+        return *this -= BasicMatrix(source);
+    }
+
+    ThreadPool::parallelForRows(rows, cols, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            T* out = rowData(i);
+            for (int j = 0; j < cols; ++j) {
+                out[j] -= source.coeff(i, j);
+            }
+        }
+    });
+    return *this;
+}
+
+namespace detail {
+
+// Operand of a product: transposed matrices are passed to the GEMM engine as a transpose flag.
+template<typename E>
+struct ProductOperand {
+    explicit ProductOperand(const E& expression) : matrix(expression) {}
+    BasicMatrix<typename E::Scalar> matrix;
+    static constexpr Transpose TRANSPOSE = Transpose::No;
+};
+
+template<typename T>
+struct ProductOperand<BasicMatrix<T>> {
+    explicit ProductOperand(const BasicMatrix<T>& matrix) : matrix(matrix) {}
+    const BasicMatrix<T>& matrix;
+    static constexpr Transpose TRANSPOSE = Transpose::No;
+};
+
+template<typename T>
+struct ProductOperand<TransposeExpression<BasicMatrix<T>>> {
+    explicit ProductOperand(const TransposeExpression<BasicMatrix<T>>& expression) : matrix(expression.operand()) {}
+    const BasicMatrix<T>& matrix;
+    static constexpr Transpose TRANSPOSE = Transpose::Yes;
+};
+
+} // detail
+
+// Matrix product with lazy operands: a transposed matrix is read in place, other expressions are materialized
+// once; then the GEMM engine multiplies them.
+template<typename L, typename R>
+BasicMatrix<typename L::Scalar> operator*(const MatrixExpression<L>& lhs, const MatrixExpression<R>& rhs) {
+    static_assert(std::is_same_v<typename L::Scalar, typename R::Scalar>, "operands must have the same scalar type");
+    const detail::ProductOperand<L> a(lhs.self());
+    const detail::ProductOperand<R> b(rhs.self());
+    BasicMatrix<typename L::Scalar> result;
+    BasicMatrix<typename L::Scalar>::multiplyInto(
+        result, a.matrix, detail::ProductOperand<L>::TRANSPOSE, b.matrix, detail::ProductOperand<R>::TRANSPOSE
+    );
+    return result;
+}
+
 } // nnn
 
 #endif //MATRIX_HPP
@@ -0,0 +1,215 @@
+#ifndef MATRIX_EXPRESSION_HPP
+#define MATRIX_EXPRESSION_HPP
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace nnn {
+
+template<typename T>
+class BasicMatrix;
+
+// Lazily evaluated element-wise matrix arithmetic. Operators build a tree of expression nodes; nothing is
+// computed until the tree is assigned to a Matrix (or used in `+=`/`-=`), which then runs a single fused
+// loop writing a single buffer. Dimension errors are still reported when the operator is applied.
+//
+// Nodes refer to Matrix operands by reference, so an expression must not outlive the matrices it was built
+// from. Store results in a Matrix rather than in `auto` variables. Every node has the `Scalar` type of its
+// operands, which must agree.
+template<typename E>
+class MatrixExpression {
+public:
+    [[nodiscard]] const E& self() const {
+        return static_cast<const E&>(*this);
+    }
+
+    [[nodiscard]] int getRows() const {
+        return self().getRows();
+    }
+
+    [[nodiscard]] int getCols() const {
+        return self().getCols();
+    }
+
+    template<typename R>
+    [[nodiscard]] auto elementwiseMultiply(const MatrixExpression<R>& other) const;
+
+    [[nodiscard]] auto transposed() const;
+};
+
+namespace detail {
+
+// Matrix leaves are held by reference, intermediate nodes by value.
+template<typename E>
+struct ExpressionOperand {
+    using type = const E;
+};
+
+template<typename T>
+struct ExpressionOperand<BasicMatrix<T>> {
+    using type = const BasicMatrix<T>&;
+};
+
+template<typename E>
+using ExpressionOperandT = typename ExpressionOperand<E>::type;
+
+struct AddOperation {
+    template<typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs + rhs;
+    }
+};
+
+struct SubtractOperation {
+    template<typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs - rhs;
+    }
+};
+
+struct MultiplyOperation {
+    template<typename T>
+    static T apply(T lhs, T rhs) {
+        return lhs * rhs;
+    }
+};
+
+} // detail
+
+// Element-wise binary node. Rows of either operand are repeated (row broadcast), matching `Matrix::operator+`;
+// operators that need equal shapes check that before building the node.
+template<typename L, typename R, typename Operation>
+class BinaryExpression : public MatrixExpression<BinaryExpression<L, R, Operation>> {
+public:
+    using Scalar = typename L::Scalar;
+    static_assert(std::is_same_v<Scalar, typename R::Scalar>, "operands must have the same scalar type");
+
+    BinaryExpression(const L& lhs, const R& rhs)
+        : lhs(lhs), rhs(rhs), rows(lhs.getRows() > rhs.getRows() ? lhs.getRows() : rhs.getRows()) {}
+
+    [[nodiscard]] int getRows() const {
+        return rows;
+    }
+
+    [[nodiscard]] int getCols() const {
+        return lhs.getCols();
+    }
+
+    [[nodiscard]] Scalar coeff(int row, int col) const {
+        return Operation::apply(lhs.coeff(row % lhs.getRows(), col), rhs.coeff(row % rhs.getRows(), col));
+    }
+
+    [[nodiscard]] bool references(const BasicMatrix<Scalar>& matrix) const {
+        return lhs.references(matrix) || rhs.references(matrix);
+    }
+
+    static constexpr bool ELEMENT_LOCAL = L::ELEMENT_LOCAL && R::ELEMENT_LOCAL;
+
+private:
+    detail::ExpressionOperandT<L> lhs;
+    detail::ExpressionOperandT<R> rhs;
+    int rows;
+};
+
+template<typename E>
+class ScaleExpression : public MatrixExpression<ScaleExpression<E>> {
+public:
+    using Scalar = typename E::Scalar;
+
+    ScaleExpression(const E& expression, Scalar scalar) : expression(expression), scalar(scalar) {}
+
+    [[nodiscard]] int getRows() const {
+        return expression.getRows();
+    }
+
+    [[nodiscard]] int getCols() const {
+        return expression.getCols();
+    }
+
+    [[nodiscard]] Scalar coeff(int row, int col) const {
+        return expression.coeff(row, col) * scalar;
+    }
+
+    [[nodiscard]] bool references(const BasicMatrix<Scalar>& matrix) const {
+        return expression.references(matrix);
+    }
+
+    static constexpr bool ELEMENT_LOCAL = E::ELEMENT_LOCAL;
+
+private:
+    detail::ExpressionOperandT<E> expression;
+    Scalar scalar;
+};
+
+template<typename E>
+class TransposeExpression : public MatrixExpression<TransposeExpression<E>> {
+public:
+    using Scalar = typename E::Scalar;
+
+    explicit TransposeExpression(const E& expression) : expression(expression) {}
+
+    [[nodiscard]] int getRows() const {
+        return expression.getCols();
+    }
+
+    [[nodiscard]] int getCols() const {
+        return expression.getRows();
+    }
+
+    [[nodiscard]] Scalar coeff(int row, int col) const {
+        return expression.coeff(col, row);
+    }
+
+    [[nodiscard]] bool references(const BasicMatrix<Scalar>& matrix) const {
+        return expression.references(matrix);
+    }
+
+    // Element (i, j) reads (j, i), so evaluating in place over an operand would overwrite unread input.
+    static constexpr bool ELEMENT_LOCAL = false;
+
+    [[nodiscard]] const E& operand() const {
+        return expression;
+    }
+
+private:
+    detail::ExpressionOperandT<E> expression;
+};
+
+template<typename L, typename R>
+auto operator+(const MatrixExpression<L>& lhs, const MatrixExpression<R>& rhs) {
+    if (lhs.getCols() != rhs.getCols()) {
+        throw std::runtime_error("Matrix::operator+: matrix columns do not match");
+    }
+    return BinaryExpression<L, R, detail::AddOperation>(lhs.self(), rhs.self());
+}
+
+template<typename L, typename R>
+auto operator-(const MatrixExpression<L>& lhs, const MatrixExpression<R>& rhs) {
+    if (lhs.getRows() != rhs.getRows() || lhs.getCols() != rhs.getCols()) {
+        throw std::runtime_error("Matrix::operator-: matrix dimensions do not match");
+    }
+    return BinaryExpression<L, R, detail::SubtractOperation>(lhs.self(), rhs.self());
+}
+
+template<typename E>
+auto operator*(const MatrixExpression<E>& expression, typename E::Scalar scalar) {
+    return ScaleExpression<E>(expression.self(), scalar);
+}
+
+template<typename E>
+template<typename R>
+auto MatrixExpression<E>::elementwiseMultiply(const MatrixExpression<R>& other) const {
+    if (getRows() != other.getRows() || getCols() != other.getCols()) {
+        throw std::runtime_error("Matrix::elementwiseMultiply: matrix dimensions do not match");
+    }
+    return BinaryExpression<E, R, detail::MultiplyOperation>(self(), other.self());
+}
+
+template<typename E>
+auto MatrixExpression<E>::transposed() const {
+    return TransposeExpression<E>(self());
+}
+
+} // nnn
+
+#endif //MATRIX_EXPRESSION_HPP
@@ -1,23 +1,120 @@
 #ifndef NEURAL_NETWORK_HPP
 #define NEURAL_NETWORK_HPP
 #include "layer.hpp"
+#include "mapped_file.hpp"
 #include "matrix.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include <span>
+#include <string>
+#include "training.hpp"
 #include <vector>
 
 namespace nnn {
 
+class Dataset;
+
+enum class LoadMode {
+    // Reads the parameters into a buffer owned by the network.
+    Copy,
+    // Maps the file and uses its parameter block in place, so loading reads nothing up front and processes
+    // that load the same file share its pages. Writes to the parameters, e.g. by training, stay private.
+    Map,
+};
+
+// All weights and biases live in one contiguous, 64-byte aligned parameter buffer; the layers' matrices are
+// views into it. Copying a network is one buffer copy, and whole-network passes can run over the flat array.
 class NeuralNetwork {
 public:
     explicit NeuralNetwork(const std::vector<int>& layerSizes);
+    // `activations[i]` is used by the layer between `layerSizes[i]` and `layerSizes[i + 1]`.
+    NeuralNetwork(const std::vector<int>& layerSizes, const std::vector<Activation>& activations);
     NeuralNetwork(const NeuralNetwork& other);
     NeuralNetwork(NeuralNetwork&& other) noexcept;
     NeuralNetwork& operator=(const NeuralNetwork& other);
     NeuralNetwork& operator=(NeuralNetwork&& other) noexcept;
     Matrix predict(const Matrix& input);
+    // Allocation-free once warmed up: hidden activations ping-pong between two buffers owned by the network
+    // and the last layer writes straight into `output`, reusing its buffer.
+    void predict(const Matrix& input, Matrix& output);
     void randomize(float low, float high);
+    // Layer `i` draws from `random.split(i)`.
+    void randomize(float low, float high, const Random& random);
+    // Genetic training, see `TrainingMode::Genetic`.
     void train(const Matrix& X, const Matrix& Y, int epochs, float learningRate);
+    // `optimizer` and `batchSize` only apply to backpropagation, which minimizes the batch mean of the per-sample
+    // `LossFunction::meanSquaredError`; batches are drawn from a fresh shuffle of the rows every epoch.
+    void train(
+        const Matrix& X, const Matrix& Y, int epochs, float learningRate, TrainingMode mode,
+        OptimizerType optimizer = OptimizerType::Adam, int batchSize = 32
+    );
+    // Backpropagation over a mapped dataset, in batches of consecutive rows (see `BatchLoader`), so that the
+    // data never has to be resident as a whole. Shuffle the rows when writing the dataset if needed.
+    void train(
+        const Dataset& dataset, int epochs, float learningRate, OptimizerType optimizer = OptimizerType::Adam,
+        int batchSize = 32
+    );
+    // Training with callbacks, early stopping and logging as set in `options` (see training.hpp); the overloads
+    // above run all their epochs and log to standard output.
+    TrainingResult train(const Matrix& X, const Matrix& Y, const TrainingOptions& options);
+    // `options.mode` must be `TrainingMode::Backpropagation`.
+    TrainingResult train(const Dataset& dataset, const TrainingOptions& options);
+
+    // Writes the architecture and the parameter buffer in the binary model format (see `neural_network.cpp`).
+    void save(const std::string& path) const;
+    // Reads a network written by `save`. Verifying the checksum reads the whole file, which a mapped load
+    // can skip when startup time matters more than detecting corruption.
+    [[nodiscard]] static NeuralNetwork load(
+        const std::string& path, LoadMode mode = LoadMode::Copy, bool verifyChecksum = true
+    );
+
+    // The parameter buffer: layer by layer, weights then biases, each starting on a cache line. Includes the
+    // row padding of the layer matrices, whose values are never read.
+    [[nodiscard]] std::span<float> getParameters();
+    [[nodiscard]] std::span<const float> getParameters() const;
+
 private:
+    struct LayerShape {
+        int inputSize;
+        int outputSize;
+        Activation activation;
+    };
+
+    friend class Population;
+    friend class QuantizedNetwork;
+    template<int... Sizes>
+    friend class StaticNetwork;
+
+    NeuralNetwork() = default;
+
+    // Gradient buffers for backpropagation: `buffer` is laid out like `parameters`, and `weights` and `biases`
+    // are per-layer views into it.
+    struct Gradients {
+        Matrix buffer;
+        std::vector<Matrix> weights;
+        std::vector<Matrix> biases;
+        Matrix deltas[2];
+    };
+
+    TrainingResult trainGenetic(const Matrix& X, const Matrix& Y, const TrainingOptions& options);
+    TrainingResult trainBackpropagation(const Matrix& X, const Matrix& Y, const TrainingOptions& options);
+
+    [[nodiscard]] Gradients makeGradients() const;
+    // Forward and backward pass over one batch, leaving the gradients of the batch mean loss in `gradients`.
+    // Returns the summed per-sample loss.
+    float backpropagate(const Matrix& X, const Matrix& Y, Gradients& gradients);
+
+    // Points the layers' matrices at their parts of `parameters`, one layer per shape.
+    void bindLayers();
+    // Floats a layer occupies in the parameter buffer.
+    static std::size_t parameterCount(int inputSize, int outputSize);
+
     std::vector<Layer> layers;
+    Matrix activations[2];
+    Matrix parameters;
+    std::vector<LayerShape> shapes;
+    // Backs `parameters` when the network was loaded with `LoadMode::Map`.
+    MappedFile mapping;
 };
 
 } // nnn
@@ -0,0 +1,44 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace nnn {
+
+enum class OptimizerType {
+    Sgd,
+    Momentum,
+    Adam,
+};
+
+// Gradient-descent update rule over a flat parameter array (see `NeuralNetwork::getParameters`). Keeps one
+// state value per parameter for momentum and two for Adam.
+class Optimizer {
+public:
+    static constexpr float MOMENTUM = 0.9f;
+    static constexpr float ADAM_BETA1 = 0.9f;
+    static constexpr float ADAM_BETA2 = 0.999f;
+    static constexpr float ADAM_EPSILON = 1e-8f;
+
+    Optimizer(OptimizerType type, float learningRate, std::size_t parameterCount);
+
+    // One update of `parameters` against `gradients`, both `parameterCount` long.
+    void step(std::span<float> parameters, std::span<const float> gradients);
+
+    [[nodiscard]] OptimizerType getType() const;
+    [[nodiscard]] float getLearningRate() const;
+    void setLearningRate(float learningRate);
+
+private:
+    OptimizerType type;
+    float learningRate;
+    // Velocity for momentum, first moment for Adam.
+    std::vector<float> firstMoments;
+    std::vector<float> secondMoments;
+    int steps = 0;
+};
+
+} // nnn
+
+#endif //OPTIMIZER_HPP
@@ -0,0 +1,52 @@
+#ifndef POPULATION_HPP
+#define POPULATION_HPP
+#include "matrix.hpp"
+#include "neural_network.hpp"
+#include "random.hpp"
+#include <span>
+
+namespace nnn {
+
+// Genetic-algorithm population of networks sharing one architecture. Individual `i`'s parameters are row `i`
+// of one preallocated block (laid out like `NeuralNetwork::getParameters()`), and the next generation is bred
+// into a second block; the two swap by index, so an epoch allocates nothing once the population is built.
+class Population {
+public:
+    // `size` copies of `prototype`.
+    Population(const NeuralNetwork& prototype, int size);
+
+    [[nodiscard]] int size() const;
+    [[nodiscard]] std::size_t parameterCount() const;
+    [[nodiscard]] std::span<float> parameters(int individual);
+    [[nodiscard]] std::span<const float> parameters(int individual) const;
+
+    // Mean squared error of every individual on (X, Y), written to `scores`. The whole population runs one
+    // layer at a time: the first layer as one wide product of X with every individual's weights side by side,
+    // later layers as a strided-batched product over the individuals' column blocks of the previous output.
+    void evaluate(const Matrix& X, const Matrix& Y, std::span<float> scores);
+    // Replaces the population with its offspring. Individual `i < parents.size()` of the next generation is
+    // a mutated copy of current individual `parents[i]`: each parameter is mutated with probability
+    // `mutationRate` by a uniform value in [-1, 1), individual `i` drawing from `random.split(i)`. The rest
+    // are copies of offspring picked by `random`. Every row is written exactly once.
+    void breed(std::span<const int> parents, float mutationRate, Random& random);
+    // Copies individual `individual` into `network`, which must have the population's architecture.
+    void copyTo(int individual, NeuralNetwork& network) const;
+
+private:
+    Matrix& current();
+    [[nodiscard]] const Matrix& current() const;
+
+    Matrix generations[2];
+    int currentGeneration = 0;
+    // Provides the architecture and the parameter layout of every individual.
+    NeuralNetwork prototype;
+    // First-layer weights and biases of all individuals side by side, and the outputs of every layer with
+    // individual `i` in columns [i * outputSize, (i + 1) * outputSize).
+    Matrix stackedWeights;
+    Matrix stackedBiases;
+    Matrix outputs[2];
+};
+
+} // nnn
+
+#endif //POPULATION_HPP
@@ -0,0 +1,109 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nnn {
+
+enum class ProfileCounter {
+    // Floating-point operations of matrix products, two per multiply-add.
+    Flops,
+    // Bytes that kernels have to read and write at least: product operands and results, activation inputs
+    // and outputs, transposes.
+    Bytes,
+    // Buffers acquired by matrices, from constructors or from a `resize` that had to grow, and their size.
+    MatrixAllocations,
+    MatrixBytes,
+};
+
+// Statistics of one named zone, summed over every thread that entered it.
+struct ProfileZone {
+    std::string name;
+    // Layer index for per-layer zones, -1 otherwise.
+    int index = -1;
+    std::uint64_t calls = 0;
+    std::uint64_t totalNs = 0;
+    std::uint64_t maxNs = 0;
+};
+
+struct ProfileSnapshot {
+    // Longest total time first. Nested zones are also part of their parents' time, and zones entered on
+    // several threads at once add up to more than the wall-clock time.
+    std::vector<ProfileZone> zones;
+    std::uint64_t flops = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t matrixAllocations = 0;
+    std::uint64_t matrixBytes = 0;
+    // Zones left out of the trace because a thread's trace buffer was full; they still count in `zones`.
+    std::uint64_t droppedEvents = 0;
+};
+
+// Hot-path profiler, compiled in when the library is built with NNN_PROFILING (the NNN_PROFILING CMake option).
+// The library marks its kernels, layers and training steps with NNN_PROFILE_SCOPE and NNN_PROFILE_COUNT; without
+// the flag those expand to nothing, so there is no cost at all, and `snapshot` is empty. Zones are recorded per
+// thread, so timers inside pool workers do not contend.
+class Profiler {
+public:
+    Profiler() = delete;
+    Profiler(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    Profiler& operator=(Profiler&&) = delete;
+
+#ifdef NNN_PROFILING
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+    // Trace events kept per thread between resets.
+    static constexpr std::size_t TRACE_CAPACITY = 1 << 18;
+
+    static void add(ProfileCounter counter, std::uint64_t value);
+    // Adds one zone entered at `startNs` and left at `endNs`, as measured by `now`.
+    static void record(const char* name, int index, std::uint64_t startNs, std::uint64_t endNs);
+    // Nanoseconds since the profiler's epoch.
+    [[nodiscard]] static std::uint64_t now();
+
+    [[nodiscard]] static ProfileSnapshot snapshot();
+    // Clears zones, counters and trace events. Zones that are open on other threads at the time are still
+    // recorded when they close.
+    static void reset();
+    // Writes the trace events as Chrome trace-event JSON, viewable in Perfetto or chrome://tracing, with the
+    // counters under "otherData".
+    static void writeChromeTrace(const std::string& path);
+};
+
+// Records the enclosing scope as zone `name`, which must be a string literal or otherwise outlive the profiler.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* name, int index = -1) : name(name), index(index), start(Profiler::now()) {}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ~ScopedTimer() {
+        Profiler::record(name, index, start, Profiler::now());
+    }
+
+private:
+    const char* name;
+    int index;
+    std::uint64_t start;
+};
+
+} // nnn
+
+#ifdef NNN_PROFILING
+#define NNN_PROFILE_CONCAT_(a, b) a##b
+#define NNN_PROFILE_CONCAT(a, b) NNN_PROFILE_CONCAT_(a, b)
+// `NNN_PROFILE_SCOPE("name")`, or `NNN_PROFILE_SCOPE("name", index)` for one zone per layer.
+#define NNN_PROFILE_SCOPE(...) const ::nnn::ScopedTimer NNN_PROFILE_CONCAT(nnnProfileScope, __LINE__)(__VA_ARGS__)
+// `NNN_PROFILE_COUNT(Flops, 2 * m * n * k)`; the value is not evaluated without NNN_PROFILING.
+#define NNN_PROFILE_COUNT(counter, value) \
+    ::nnn::Profiler::add(::nnn::ProfileCounter::counter, static_cast<std::uint64_t>(value))
+#else
+#define NNN_PROFILE_SCOPE(...) static_cast<void>(0)
+#define NNN_PROFILE_COUNT(counter, value) static_cast<void>(0)
+#endif
+
+#endif //PROFILER_HPP
@@ -0,0 +1,99 @@
+#ifndef QUANTIZATION_HPP
+#define QUANTIZATION_HPP
+#include "activation_function.hpp"
+#include <cstddef>
+#include <cstdint>
+#include "layer.hpp"
+#include "matrix.hpp"
+#include "neural_network.hpp"
+#include <vector>
+
+namespace nnn {
+
+// Storage formats for inference weights. Activations, biases and accumulation stay fp32 except for `Int8`,
+// which also quantizes each input row on the fly and accumulates in int32.
+enum class WeightPrecision {
+    // Symmetric per-output-channel int8 weights; inputs are quantized per row with a dynamic scale, and the
+    // int32 sums are dequantized, biased and activated in one pass.
+    Int8,
+    // IEEE half precision.
+    Float16,
+    // Upper half of an fp32: fp32's range with 8 bits of mantissa.
+    BFloat16,
+};
+
+// Conversions round to nearest even and keep infinities and NaNs.
+[[nodiscard]] std::uint16_t toFloat16(float value);
+[[nodiscard]] float fromFloat16(std::uint16_t bits);
+[[nodiscard]] std::uint16_t toBFloat16(float value);
+[[nodiscard]] float fromBFloat16(std::uint16_t bits);
+
+// Inference-only copy of a Layer with reduced-precision weights, stored transposed so that every output
+// channel is one contiguous run. Uses AVX2 kernels unless the CPU lacks them or `Gemm::setKernel` forces
+// `GemmKernel::Scalar`.
+class QuantizedLayer {
+public:
+    // Channels are padded to a multiple of this many weights, so the int8 kernel needs no tail.
+    static constexpr int CHANNEL_ALIGNMENT = 32;
+
+    QuantizedLayer(const Layer& layer, WeightPrecision precision);
+
+    // Same contract as `Layer::forwardInto`.
+    void forwardInto(const Matrix& input, Matrix& output) const;
+
+    [[nodiscard]] WeightPrecision getPrecision() const;
+    [[nodiscard]] int getInputSize() const;
+    [[nodiscard]] int getOutputSize() const;
+    // Bytes of weights, scales and biases.
+    [[nodiscard]] std::size_t getWeightBytes() const;
+
+private:
+    WeightPrecision precision;
+    Activation activation;
+    int inputSize;
+    int outputSize;
+    // Elements between consecutive channels: `inputSize` rounded up to CHANNEL_ALIGNMENT, zero-padded.
+    int channelStride;
+    std::vector<std::int8_t> int8Weights;
+    std::vector<std::uint16_t> halfWeights;
+    // Per-channel dequantization scales, `Int8` only.
+    std::vector<float> scales;
+    std::vector<float> biases;
+};
+
+// Difference between a network's fp32 `predict` and its reduced-precision copy on calibration samples.
+struct CalibrationReport {
+    float maxAbsoluteError = 0.f;
+    float meanAbsoluteError = 0.f;
+    // Fraction of samples whose largest output is the same in both, i.e. the unchanged classifications.
+    float argmaxAgreement = 1.f;
+    std::size_t fp32Bytes = 0;
+    std::size_t quantizedBytes = 0;
+};
+
+// Reduced-precision inference copy of a trained network.
+class QuantizedNetwork {
+public:
+    QuantizedNetwork(const NeuralNetwork& network, WeightPrecision precision);
+
+    // Converts `network` and measures the conversion against its fp32 `predict` on `samples` (one input per
+    // row), filling `report`.
+    [[nodiscard]] static QuantizedNetwork calibrate(
+        NeuralNetwork& network, WeightPrecision precision, const Matrix& samples, CalibrationReport& report
+    );
+
+    [[nodiscard]] Matrix predict(const Matrix& input);
+    // Allocation-free once warmed up, like `NeuralNetwork::predict`.
+    void predict(const Matrix& input, Matrix& output);
+
+    [[nodiscard]] WeightPrecision getPrecision() const;
+    [[nodiscard]] std::size_t getWeightBytes() const;
+
+private:
+    std::vector<QuantizedLayer> layers;
+    Matrix activations[2];
+};
+
+} // nnn
+
+#endif //QUANTIZATION_HPP
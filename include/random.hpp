@@ -0,0 +1,55 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+#include <cstdint>
+#include <span>
+
+namespace nnn {
+
+// Counter-based random number generator (Philox4x32-10). Block `i` of a generator's output is a pure function
+// of (seed, stream, i), so bulk fills compute blocks a SIMD register at a time and split across the thread
+// pool without changing the values, and streams derived with `split` are independent of each other and of the thread that uses them.
+//
+// A generator is a small value type and is not thread-safe itself; give each thread, network or layer its
+// own stream instead of sharing one.
+class Random {
+public:
+    explicit Random(std::uint64_t seed, std::uint64_t stream = 0);
+
+    // Independent generator for sub-stream `id` of this stream, e.g. one per network or per layer.
+    // Does not advance this generator.
+    [[nodiscard]] Random split(std::uint64_t id) const;
+
+    std::uint32_t nextUint();
+    // Uniform in [0, 1).
+    float uniform();
+    float uniform(float low, float high);
+    // Normally distributed (Box-Muller).
+    float normal(float mean = 0.f, float stddev = 1.f);
+
+    // Bulk fills; they start at the next unused output block and advance the generator past the values used.
+    void fillUniform(std::span<float> values, float low, float high);
+    void fillNormal(std::span<float> values, float mean, float stddev);
+
+    // Process-wide generator behind the overloads that take no `Random`. Seeded from `std::random_device`
+    // until `setGlobalSeed` is called; every `global()` call returns the next stream of that seed, so a
+    // program that seeds it and makes the same calls in the same order gets the same numbers.
+    static void setGlobalSeed(std::uint64_t seed);
+    static Random global();
+
+private:
+    // Words produced per counter batch (16 Philox blocks, one per SIMD lane).
+    static constexpr int BUFFER_SIZE = 64;
+
+    void refill();
+
+    std::uint64_t key;
+    std::uint64_t stream;
+    // Index of the next unused batch.
+    std::uint64_t counter = 0;
+    std::uint32_t buffer[BUFFER_SIZE] = {};
+    int buffered = 0;
+};
+
+} // nnn
+
+#endif //RANDOM_HPP
@@ -0,0 +1,25 @@
+#ifndef SCALAR_TRAITS_HPP
+#define SCALAR_TRAITS_HPP
+
+namespace nnn {
+
+// Element types that matrices, layers, activations and losses can be instantiated for. Each type picks its own
+// SIMD width: the number of lanes of a 64-byte vector register, which is also the row alignment of padded
+// matrices and the column width of the portable GEMM kernel's register tile. Supporting another type, such as a
+// half type, takes a specialization here and explicit instantiations next to the float and double ones.
+template<typename T>
+struct ScalarTraits;
+
+template<>
+struct ScalarTraits<float> {
+    static constexpr int SIMD_WIDTH = 16;
+};
+
+template<>
+struct ScalarTraits<double> {
+    static constexpr int SIMD_WIDTH = 8;
+};
+
+} // nnn
+
+#endif //SCALAR_TRAITS_HPP
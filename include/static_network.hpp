@@ -0,0 +1,182 @@
+#ifndef STATIC_NETWORK_HPP
+#define STATIC_NETWORK_HPP
+#include "activation_function.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include "matrix.hpp"
+#include "neural_network.hpp"
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace nnn {
+
+// Network whose topology is fixed at compile time, e.g. `StaticNetwork<2, 4, 1>`. Parameters live inline in a
+// `std::array` (layer by layer, weights row-major then biases, without padding), and every loop bound is a
+// constant, so tiny models run without allocations, dimension checks or indirections. Train a `NeuralNetwork`
+// of the same shape and convert it to serve it from here.
+template<int... Sizes>
+class StaticNetwork {
+public:
+    static_assert(sizeof...(Sizes) >= 2, "there must be at least 2 layers");
+    static_assert(((Sizes > 0) && ...), "layer sizes must be positive");
+
+    static constexpr int LAYER_COUNT = sizeof...(Sizes) - 1;
+    static constexpr std::array<int, sizeof...(Sizes)> SIZES = { Sizes... };
+    static constexpr int INPUT_SIZE = SIZES.front();
+    static constexpr int OUTPUT_SIZE = SIZES.back();
+
+    // All parameters zero; every layer uses sigmoid, like `NeuralNetwork(layerSizes)`.
+    StaticNetwork();
+    explicit StaticNetwork(const std::array<Activation, LAYER_COUNT>& activations);
+    // Copies the parameters of `network`, which must have the same layer sizes.
+    explicit StaticNetwork(const NeuralNetwork& network);
+
+    [[nodiscard]] NeuralNetwork toNeuralNetwork() const;
+
+    [[nodiscard]] std::array<float, OUTPUT_SIZE> predict(const std::array<float, INPUT_SIZE>& input) const;
+    // One sample: `input` holds INPUT_SIZE values and `output` receives OUTPUT_SIZE.
+    void predict(const float* input, float* output) const;
+    // One sample per row of `input`.
+    void predict(const Matrix& input, Matrix& output) const;
+
+    [[nodiscard]] std::span<float> getParameters();
+    [[nodiscard]] std::span<const float> getParameters() const;
+    [[nodiscard]] Activation getActivation(int layer) const;
+
+private:
+    // Offset of each layer's weights in `parameters`; the last entry is the total.
+    static constexpr std::array<std::size_t, LAYER_COUNT + 1> OFFSETS = [] {
+        std::array<std::size_t, LAYER_COUNT + 1> offsets{};
+        for (int i = 0; i < LAYER_COUNT; ++i) {
+            offsets[i + 1] = offsets[i] + static_cast<std::size_t>(SIZES[i] + 1) * SIZES[i + 1];
+        }
+        return offsets;
+    }();
+    static constexpr int MAX_SIZE = std::max({ Sizes... });
+
+    template<std::size_t I>
+    void forwardLayer(const float* input, float* output) const;
+
+    alignas(64) std::array<float, OFFSETS.back()> parameters{};
+    std::array<Activation, LAYER_COUNT> activations;
+};
+
+template<int... Sizes>
+StaticNetwork<Sizes...>::StaticNetwork() {
+    activations.fill(Activation::Sigmoid);
+}
+
+template<int... Sizes>
+StaticNetwork<Sizes...>::StaticNetwork(const std::array<Activation, LAYER_COUNT>& activations)
+    : activations(activations) {}
+
+template<int... Sizes>
+StaticNetwork<Sizes...>::StaticNetwork(const NeuralNetwork& network) {
+    if (network.layers.size() != LAYER_COUNT) {
+        throw std::runtime_error("StaticNetwork::StaticNetwork: network has a different number of layers");
+    }
+    for (int i = 0; i < LAYER_COUNT; ++i) {
+        const Layer& layer = network.layers[i];
+        if (layer.weights.getRows() != SIZES[i] || layer.weights.getCols() != SIZES[i + 1]) {
+            throw std::runtime_error("StaticNetwork::StaticNetwork: network has different layer sizes");
+        }
+
+        float* weights = parameters.data() + OFFSETS[i];
+        for (int k = 0; k < SIZES[i]; ++k) {
+            std::copy_n(layer.weights.rowData(k), SIZES[i + 1], weights + k * SIZES[i + 1]);
+        }
+        std::copy_n(layer.biases.rowData(0), SIZES[i + 1], weights + SIZES[i] * SIZES[i + 1]);
+        activations[i] = layer.activation;
+    }
+}
+
+template<int... Sizes>
+NeuralNetwork StaticNetwork<Sizes...>::toNeuralNetwork() const {
+    NeuralNetwork network(
+        std::vector<int>(SIZES.begin(), SIZES.end()), std::vector<Activation>(activations.begin(), activations.end())
+    );
+    for (int i = 0; i < LAYER_COUNT; ++i) {
+        Layer& layer = network.layers[i];
+        const float* weights = parameters.data() + OFFSETS[i];
+        for (int k = 0; k < SIZES[i]; ++k) {
+            std::copy_n(weights + k * SIZES[i + 1], SIZES[i + 1], layer.weights.rowData(k));
+        }
+        std::copy_n(weights + SIZES[i] * SIZES[i + 1], SIZES[i + 1], layer.biases.rowData(0));
+    }
+    return network;
+}
+
+template<int... Sizes>
+std::array<float, StaticNetwork<Sizes...>::OUTPUT_SIZE> StaticNetwork<Sizes...>::predict(
+    const std::array<float, INPUT_SIZE>& input
+) const {
+    std::array<float, OUTPUT_SIZE> output;
+    predict(input.data(), output.data());
+    return output;
+}
+
+template<int... Sizes>
+void StaticNetwork<Sizes...>::predict(const float* input, float* output) const {
+    alignas(64) float buffers[2][MAX_SIZE];
+    // Layer I writes buffers[I % 2], which layer I + 1 reads; the first reads `input`, the last writes `output`.
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (forwardLayer<I>(I == 0 ? input : buffers[(I + 1) % 2], I + 1 == LAYER_COUNT ? output : buffers[I % 2]), ...);
+    }(std::make_index_sequence<LAYER_COUNT>());
+}
+
+template<int... Sizes>
+void StaticNetwork<Sizes...>::predict(const Matrix& input, Matrix& output) const {
+    if (input.getCols() != INPUT_SIZE) {
+        throw std::runtime_error("StaticNetwork::predict: input columns do not match the input size");
+    }
+    if (&input == &output) {
+        throw std::runtime_error("StaticNetwork::predict: output must not alias input");
+    }
+
+    output.resize(input.getRows(), OUTPUT_SIZE);
+    for (int i = 0; i < input.getRows(); ++i) {
+        predict(input.rowData(i), output.rowData(i));
+    }
+}
+
+template<int... Sizes>
+std::span<float> StaticNetwork<Sizes...>::getParameters() {
+    return parameters;
+}
+
+template<int... Sizes>
+std::span<const float> StaticNetwork<Sizes...>::getParameters() const {
+    return parameters;
+}
+
+template<int... Sizes>
+Activation StaticNetwork<Sizes...>::getActivation(int layer) const {
+    return activations.at(layer);
+}
+
+template<int... Sizes>
+template<std::size_t I>
+void StaticNetwork<Sizes...>::forwardLayer(const float* input, float* output) const {
+    constexpr int inputSize = SIZES[I];
+    constexpr int outputSize = SIZES[I + 1];
+    const float* weights = parameters.data() + OFFSETS[I];
+    const float* biases = weights + inputSize * outputSize;
+
+    for (int j = 0; j < outputSize; ++j) {
+        output[j] = biases[j];
+    }
+    for (int k = 0; k < inputSize; ++k) {
+        const float x = input[k];
+        for (int j = 0; j < outputSize; ++j) {
+            output[j] += x * weights[k * outputSize + j];
+        }
+    }
+    ActivationFunction::applyInPlace(activations[I], output, outputSize);
+}
+
+} // nnn
+
+#endif //STATIC_NETWORK_HPP
@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+namespace nnn {
+
+// Process-wide pool of persistent worker threads used by the library's kernels. The calling thread always
+// takes part in the work, so `getThreadCount() == 1` means no workers and fully serial execution.
+class ThreadPool {
+public:
+    ThreadPool() = delete;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Element-wise work below this many elements per task is not worth handing to another thread.
+    static constexpr int ELEMENTWISE_GRAIN = 1 << 15;
+
+    // Total threads (workers plus caller) used by `parallelFor`; `count <= 0` selects the hardware concurrency,
+    // which is also the default. Waits for running work to finish before resizing.
+    static void setThreadCount(int count);
+    static int getThreadCount();
+    // Index of the calling thread in [0, getThreadCount()): pool workers have distinct indices from 1 up, any
+    // other thread reports 0. Meant for picking per-thread scratch inside a `parallelFor` body.
+    static int threadIndex();
+
+    // Calls `body(begin, end)` on disjoint chunks that together cover [0, count), balanced over the pool by
+    // work stealing. Chunks are at least `grain` long apart from the last one. The work runs serially on the
+    // caller when `count` does not exceed `grain`, when the pool has a single thread, when called from inside
+    // another `parallelFor`, or while another thread is using the pool. Returns once every chunk has
+    // finished; the first exception thrown by `body` is rethrown.
+    template<typename F>
+    static void parallelFor(int count, int grain, F&& body);
+    // `parallelFor` over `rows` rows of `rowLength` elements each, in tasks of about ELEMENTWISE_GRAIN elements.
+    template<typename F>
+    static void parallelForRows(int rows, int rowLength, F&& body);
+
+private:
+    using Task = void (*)(void* context, int begin, int end);
+    static void run(int count, int grain, Task task, void* context);
+};
+
+template<typename F>
+void ThreadPool::parallelFor(int count, int grain, F&& body) {
+    if (count <= 0) {
+        return;
+    }
+    if (count <= grain) {
+        body(0, count);
+        return;
+    }
+
+    using Body = std::remove_reference_t<F>;
+    run(count, grain, [](void* context, int begin, int end) {
+        (*static_cast<Body*>(context))(begin, end);
+    }, const_cast<void*>(static_cast<const void*>(&body)));
+}
+
+template<typename F>
+void ThreadPool::parallelForRows(int rows, int rowLength, F&& body) {
+    parallelFor(rows, std::max(1, ELEMENTWISE_GRAIN / std::max(rowLength, 1)), std::forward<F>(body));
+}
+
+} // nnn
+
+#endif //THREAD_POOL_HPP
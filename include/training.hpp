@@ -0,0 +1,146 @@
+#ifndef TRAINING_HPP
+#define TRAINING_HPP
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include "optimizer.hpp"
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nnn {
+
+enum class TrainingMode {
+    // Genetic algorithm over a population of mutated copies; ignores the learning rate.
+    Genetic,
+    // Mini-batch gradient descent with backpropagation.
+    Backpropagation,
+};
+
+enum class StopReason {
+    // All `TrainingOptions::epochs` ran.
+    Completed,
+    LossTarget,
+    Plateau,
+    TimeBudget,
+    // `TrainingOptions::onEpoch` returned false.
+    Callback,
+};
+
+struct EpochMetrics {
+    int epoch = 0;
+    // Mean per-sample loss over the epoch for backpropagation, loss of the best individual for genetic training.
+    float loss = 0.f;
+    double epochSeconds = 0.;
+    // Since training started, this epoch included.
+    double elapsedSeconds = 0.;
+};
+
+struct TrainingResult {
+    // Epochs that ran, i.e. the length of `losses`.
+    int epochs = 0;
+    StopReason stopReason = StopReason::Completed;
+    // `EpochMetrics::loss` of every epoch.
+    std::vector<float> losses;
+    double seconds = 0.;
+};
+
+// Destination of training progress lines.
+class LogSink {
+public:
+    LogSink() = default;
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+    virtual ~LogSink() = default;
+
+    // One line, without its terminating newline.
+    virtual void write(std::string line) = 0;
+    // Returns once every line written so far has reached its destination.
+    virtual void flush() = 0;
+
+    // Process-wide buffered sink over `std::cout`, the default for training. Training flushes it before
+    // returning, so `std::cout` is free for the caller again once `train` returns.
+    static LogSink& standardOutput();
+};
+
+// Hands lines to a background thread that writes them to `stream`, so that the caller never waits for I/O.
+// The destructor writes out whatever is still pending. `stream` must outlive the sink, and must not be used
+// by other threads while lines are pending.
+class BufferedLogSink final : public LogSink {
+public:
+    explicit BufferedLogSink(std::ostream& stream);
+    ~BufferedLogSink() override;
+
+    void write(std::string line) override;
+    void flush() override;
+
+private:
+    void run();
+
+    std::ostream& stream;
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    std::vector<std::string> pending;
+    bool writing = false;
+    bool stopping = false;
+    std::thread worker;
+};
+
+struct TrainingOptions {
+    int epochs = 100;
+    float learningRate = 0.01f;
+    TrainingMode mode = TrainingMode::Backpropagation;
+    // `optimizer` and `batchSize` only apply to backpropagation.
+    OptimizerType optimizer = OptimizerType::Adam;
+    int batchSize = 32;
+
+    // Stops once an epoch's loss is at or below this; negative disables.
+    float targetLoss = -1.f;
+    // Stops when the loss has not improved on the best one so far by more than `minImprovement` for `patience`
+    // epochs in a row; 0 disables.
+    int patience = 0;
+    float minImprovement = 0.f;
+    // Stops after the first epoch that ends this many seconds after training started; 0 disables. Epochs are
+    // never interrupted, so training overruns the budget by up to one epoch.
+    double timeBudgetSeconds = 0.;
+
+    // Called after every epoch, on the training thread; returning false stops training.
+    std::function<bool(const EpochMetrics&)> onEpoch;
+    // Progress is logged every `logInterval` epochs, starting with the first; 0 disables.
+    int logInterval = 25;
+    // Null logs to `LogSink::standardOutput()`. The sink is flushed before `train` returns.
+    LogSink* log = nullptr;
+};
+
+// Per-epoch bookkeeping shared by the training loops: timing, loss history, logging, callbacks and the
+// stopping rules of `options`.
+class TrainingMonitor {
+public:
+    // `lossLabel` names the loss in log lines, e.g. "mean loss".
+    TrainingMonitor(const TrainingOptions& options, const char* lossLabel);
+
+    [[nodiscard]] bool shouldContinue() const;
+    // Ends the current epoch with its loss, and decides whether another one should run.
+    void endEpoch(float loss);
+    // Flushes the log and returns the result.
+    [[nodiscard]] TrainingResult finish();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const TrainingOptions& options;
+    const char* lossLabel;
+    LogSink& log;
+    Clock::time_point start;
+    Clock::time_point epochStart;
+    TrainingResult result;
+    bool stopped = false;
+    float bestLoss;
+    int epochsWithoutImprovement = 0;
+};
+
+} // nnn
+
+#endif //TRAINING_HPP
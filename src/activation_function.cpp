@@ -1,15 +1,518 @@
+#include <algorithm>
 #include "activation_function.hpp"
+#include <atomic>
 #include <cmath>
-using namespace nnn;
+#include <cstdint>
+#include <cstring>
+#include "profiler.hpp"
+#include "thread_pool.hpp"
+#include <type_traits>
 
-Matrix ActivationFunction::sigmoid(const Matrix &x) {
-    Matrix result(x.getRows(), x.getCols());
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNN_ACTIVATION_X86
+#endif
 
-    for (int i = 0; i < x.getRows(); i++) {
-        for (int j = 0; j < x.getCols(); j++) {
-            result(i, j) = 1.f / (1.f + std::exp(-x(i, j)));
+#define NNN_ALWAYS_INLINE inline __attribute__((always_inline))
+
+namespace nnn {
+
+namespace {
+
+// The SIMD kernels are written once against GCC vector extensions and instantiated per vector width
+// inside functions compiled for the matching instruction set. Everything in between is force-inlined,
+// so vector values never cross a call boundary; the ABI note GCC emits for such helpers does not apply.
+// GCC reports some of those notes at the end of the file instead, so the build also disables them for it.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+template<int W>
+struct Vec {
+    typedef float F __attribute__((vector_size(W * sizeof(float))));
+    typedef std::int32_t I __attribute__((vector_size(W * sizeof(float))));
+};
+
+template<typename F>
+NNN_ALWAYS_INLINE F splat(float value) {
+    return F{} + value;
+}
+
+template<typename To, typename From>
+NNN_ALWAYS_INLINE To bitCast(From value) {
+    To result;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+template<typename F, typename I>
+NNN_ALWAYS_INLINE F absolute(F x) {
+    return bitCast<F>(bitCast<I>(x) & 0x7fffffff);
+}
+
+template<typename F, typename I>
+NNN_ALWAYS_INLINE F copySign(F magnitude, F sign) {
+    return bitCast<F>(bitCast<I>(magnitude) | (bitCast<I>(sign) & static_cast<std::int32_t>(0x80000000u)));
+}
+
+// exp(x) = 2^n * exp(r) with |r| <= ln(2) / 2. The clamp keeps 2^n a normal float; the upper bound is
+// below ln(FLT_MAX) because every caller only needs exp of non-positive values or saturates anyway.
+constexpr float EXP_MIN = -87.33654f;
+constexpr float EXP_MAX = 88.f;
+constexpr float LOG2E = 1.44269504f;
+constexpr float LN2_HIGH = 0.693359375f;
+constexpr float LN2_LOW = -2.12194440e-4f;
+constexpr float ROUNDING_MAGIC = 12582912.f;
+
+template<typename F, typename I, ActivationAccuracy Accuracy>
+NNN_ALWAYS_INLINE F expApprox(F x) {
+    x = x < EXP_MIN ? splat<F>(EXP_MIN) : x;
+    x = x > EXP_MAX ? splat<F>(EXP_MAX) : x;
+
+    const F n = (x * LOG2E + ROUNDING_MAGIC) - ROUNDING_MAGIC;
+    F r = x - n * LN2_HIGH;
+    r = r - n * LN2_LOW;
+
+    F p;
+    if constexpr (Accuracy == ActivationAccuracy::UltraFast) {
+        // Minimax cubic, 7.5e-5 relative error.
+        p = splat<F>(0.16566842f);
+        p = p * r + 0.50496326f;
+        p = p * r + 1.00016419f;
+        p = p * r + 0.99992807f;
+    } else {
+        // Cephes expf polynomial, ~2 ulp.
+        p = splat<F>(1.9875691500e-4f);
+        p = p * r + 1.3981999507e-3f;
+        p = p * r + 8.3334519073e-3f;
+        p = p * r + 4.1665795894e-2f;
+        p = p * r + 1.6666665459e-1f;
+        p = p * r + 5.0000001201e-1f;
+        p = p * r * r + r + 1.f;
+    }
+
+    const I exponent = (__builtin_convertvector(n, I) + 127) << 23;
+    return p * bitCast<F>(exponent);
+}
+
+template<ActivationAccuracy Accuracy>
+struct SigmoidOp {
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        return 1.f / (1.f + expApprox<F, I, Accuracy>(-x));
+    }
+};
+
+template<ActivationAccuracy Accuracy>
+struct TanhOp {
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        const F t = expApprox<F, I, Accuracy>(-2.f * absolute<F, I>(x));
+        return copySign<F, I>((1.f - t) / (1.f + t), x);
+    }
+};
+
+struct ReluOp {
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        return x > 0.f ? x : F{};
+    }
+};
+
+struct LeakyReluOp {
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        return x > 0.f ? x : x * ActivationFunction::LEAKY_RELU_SLOPE;
+    }
+};
+
+template<ActivationAccuracy Accuracy>
+struct GeluOp {
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        if constexpr (Accuracy == ActivationAccuracy::UltraFast) {
+            // tanh approximation of GELU.
+            const F inner = 0.7978845608f * (x + 0.044715f * x * x * x);
+            return 0.5f * x * (1.f + TanhOp<Accuracy>().template apply<F, I>(inner));
+        } else {
+            // erf from Abramowitz & Stegun 7.1.26 (1.5e-7 absolute error).
+            const F z = absolute<F, I>(x) * 0.70710678f;
+            const F t = 1.f / (1.f + 0.3275911f * z);
+            F poly = splat<F>(1.061405429f);
+            poly = poly * t - 1.453152027f;
+            poly = poly * t + 1.421413741f;
+            poly = poly * t - 0.284496736f;
+            poly = poly * t + 0.254829592f;
+            const F erf = 1.f - poly * t * expApprox<F, I, Accuracy>(-z * z);
+            return 0.5f * x * (1.f + copySign<F, I>(erf, x));
         }
     }
+};
 
+// exp(x - max) for the numerator of softmax.
+template<ActivationAccuracy Accuracy>
+struct ShiftedExpOp {
+    float shift;
+
+    template<typename F, typename I>
+    NNN_ALWAYS_INLINE F apply(F x) const {
+        return expApprox<F, I, Accuracy>(x - shift);
+    }
+};
+
+// Runs `op` over full vectors, then over the zero-padded tail.
+template<int W, typename Op>
+NNN_ALWAYS_INLINE void forEach(float* values, int count, const Op& op) {
+    using F = typename Vec<W>::F;
+    using I = typename Vec<W>::I;
+
+    int i = 0;
+    for (; i + W <= count; i += W) {
+        F x;
+        std::memcpy(&x, values + i, sizeof(x));
+        x = op.template apply<F, I>(x);
+        std::memcpy(values + i, &x, sizeof(x));
+    }
+    if (i < count) {
+        const std::size_t tail = (count - i) * sizeof(float);
+        F x{};
+        std::memcpy(&x, values + i, tail);
+        x = op.template apply<F, I>(x);
+        std::memcpy(values + i, &x, tail);
+    }
+}
+
+template<int W, ActivationAccuracy Accuracy>
+NNN_ALWAYS_INLINE void softmaxRow(float* values, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    const float max = *std::max_element(values, values + count);
+    forEach<W>(values, count, ShiftedExpOp<Accuracy>{ max });
+
+    float sum = 0.f;
+    for (int i = 0; i < count; ++i) {
+        sum += values[i];
+    }
+    const float scale = 1.f / sum;
+    for (int i = 0; i < count; ++i) {
+        values[i] *= scale;
+    }
+}
+
+// One table of in-place kernels per instruction set, indexed by Activation.
+struct KernelSet {
+    ActivationFunction::Kernel fast[6];
+    ActivationFunction::Kernel ultraFast[6];
+};
+
+#define NNN_DEFINE_ACTIVATION_KERNELS(SUFFIX, TARGET, WIDTH)                                           \
+    template<ActivationAccuracy Accuracy>                                                              \
+    TARGET void sigmoid##SUFFIX(float* values, int count) {                                            \
+        forEach<WIDTH>(values, count, SigmoidOp<Accuracy>());                                          \
+    }                                                                                                  \
+    template<ActivationAccuracy Accuracy>                                                              \
+    TARGET void tanh##SUFFIX(float* values, int count) {                                               \
+        forEach<WIDTH>(values, count, TanhOp<Accuracy>());                                             \
+    }                                                                                                  \
+    TARGET void relu##SUFFIX(float* values, int count) {                                               \
+        forEach<WIDTH>(values, count, ReluOp());                                                       \
+    }                                                                                                  \
+    TARGET void leakyRelu##SUFFIX(float* values, int count) {                                          \
+        forEach<WIDTH>(values, count, LeakyReluOp());                                                  \
+    }                                                                                                  \
+    template<ActivationAccuracy Accuracy>                                                              \
+    TARGET void gelu##SUFFIX(float* values, int count) {                                               \
+        forEach<WIDTH>(values, count, GeluOp<Accuracy>());                                             \
+    }                                                                                                  \
+    template<ActivationAccuracy Accuracy>                                                              \
+    TARGET void softmax##SUFFIX(float* values, int count) {                                            \
+        softmaxRow<WIDTH, Accuracy>(values, count);                                                    \
+    }                                                                                                  \
+    const KernelSet kernels##SUFFIX = {                                                                \
+        {                                                                                              \
+            sigmoid##SUFFIX<ActivationAccuracy::Fast>, tanh##SUFFIX<ActivationAccuracy::Fast>,         \
+            relu##SUFFIX, leakyRelu##SUFFIX,                                                           \
+            gelu##SUFFIX<ActivationAccuracy::Fast>, softmax##SUFFIX<ActivationAccuracy::Fast>,         \
+        },                                                                                             \
+        {                                                                                              \
+            sigmoid##SUFFIX<ActivationAccuracy::UltraFast>, tanh##SUFFIX<ActivationAccuracy::UltraFast>, \
+            relu##SUFFIX, leakyRelu##SUFFIX,                                                           \
+            gelu##SUFFIX<ActivationAccuracy::UltraFast>, softmax##SUFFIX<ActivationAccuracy::UltraFast>, \
+        },                                                                                             \
+    };
+
+NNN_DEFINE_ACTIVATION_KERNELS(Generic, , 4)
+#ifdef NNN_ACTIVATION_X86
+NNN_DEFINE_ACTIVATION_KERNELS(Avx2, __attribute__((target("avx2,fma"))), 8)
+NNN_DEFINE_ACTIVATION_KERNELS(Avx512, __attribute__((target("avx512f"))), 16)
+#endif
+
+const KernelSet& simdKernels() {
+#ifdef NNN_ACTIVATION_X86
+    static const KernelSet& selected =
+        __builtin_cpu_supports("avx512f") ? kernelsAvx512
+        : __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? kernelsAvx2
+        : kernelsGeneric;
+    return selected;
+#else
+    return kernelsGeneric;
+#endif
+}
+
+#pragma GCC diagnostic pop
+
+template<typename T>
+void sigmoidExact(T* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = T(1) / (T(1) + std::exp(-values[i]));
+    }
+}
+
+template<typename T>
+void tanhExact(T* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = std::tanh(values[i]);
+    }
+}
+
+template<typename T>
+void reluExact(T* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = std::max(values[i], T(0));
+    }
+}
+
+template<typename T>
+void leakyReluExact(T* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = values[i] > T(0) ? values[i] : values[i] * BasicActivationFunction<T>::LEAKY_RELU_SLOPE;
+    }
+}
+
+template<typename T>
+void geluExact(T* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = T(0.5) * values[i] * (T(1) + std::erf(values[i] * T(0.70710678118654752)));
+    }
+}
+
+template<typename T>
+void softmaxExact(T* values, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    const T max = *std::max_element(values, values + count);
+    T sum = 0;
+    for (int i = 0; i < count; ++i) {
+        values[i] = std::exp(values[i] - max);
+        sum += values[i];
+    }
+    for (int i = 0; i < count; ++i) {
+        values[i] /= sum;
+    }
+}
+
+std::atomic<ActivationAccuracy> currentAccuracy{ ActivationAccuracy::Exact };
+
+template<typename T>
+BasicMatrix<T> applied(Activation activation, const BasicMatrix<T>& x) {
+    BasicMatrix<T> result;
+    BasicActivationFunction<T>::applyInto(activation, result, x);
     return result;
 }
+
+} // namespace
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::sigmoid(const Matrix& x) {
+    return applied(Activation::Sigmoid, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::tanh(const Matrix& x) {
+    return applied(Activation::Tanh, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::relu(const Matrix& x) {
+    return applied(Activation::ReLU, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::leakyRelu(const Matrix& x) {
+    return applied(Activation::LeakyReLU, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::gelu(const Matrix& x) {
+    return applied(Activation::GELU, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::softmax(const Matrix& x) {
+    return applied(Activation::Softmax, x);
+}
+
+template<typename T>
+BasicMatrix<T> BasicActivationFunction<T>::apply(Activation activation, const Matrix& x) {
+    return applied(activation, x);
+}
+
+template<typename T>
+void BasicActivationFunction<T>::sigmoidInto(Matrix& out, const Matrix& x) {
+    applyInto(Activation::Sigmoid, out, x);
+}
+
+template<typename T>
+void BasicActivationFunction<T>::applyInto(Activation activation, Matrix& out, const Matrix& x) {
+    NNN_PROFILE_SCOPE("activation");
+    NNN_PROFILE_COUNT(Bytes, 2 * sizeof(T) * static_cast<std::size_t>(x.getRows()) * x.getCols());
+    const Kernel run = kernel(activation);
+    const int rows = x.getRows();
+    const int cols = x.getCols();
+    if (&out != &x) {
+        out.resize(rows, cols);
+    }
+
+    // Softmax needs row boundaries, and views with their own stride must not touch what lies between their rows.
+    if (activation == Activation::Softmax || !x.hasPaddedLayout() || out.getStride() != x.getStride()) {
+        ThreadPool::parallelForRows(rows, cols, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                T* row = out.rowData(i);
+                if (&out != &x) {
+                    std::copy_n(x.rowData(i), cols, row);
+                }
+                run(row, cols);
+            }
+        });
+        return;
+    }
+
+    // Element-wise activations ignore row boundaries, so consecutive rows (with their padding) form one run.
+    // Padded rows are a multiple of every vector width long, so those runs have no remainder. Runs are about
+    // BLOCK_SIZE floats, so each copied block is transformed while still in L1. Blocks are spread over the
+    // thread pool; SIMD lanes are independent, so where a block boundary falls does not change any result.
+    constexpr int BLOCK_SIZE = 4096;
+    const int stride = x.getStride();
+    const int rowsPerBlock = std::max(1, BLOCK_SIZE / std::max(stride, 1));
+    const int blocks = (rows + rowsPerBlock - 1) / rowsPerBlock;
+    ThreadPool::parallelForRows(blocks, rowsPerBlock * stride, [&](int begin, int end) {
+        for (int block = begin; block < end; ++block) {
+            const int first = block * rowsPerBlock;
+            const int count = std::min(rowsPerBlock, rows - first) * stride;
+            T* values = out.rowData(first);
+            if (&out != &x) {
+                std::copy_n(x.rowData(first), count, values);
+            }
+            run(values, count);
+        }
+    });
+}
+
+template<typename T>
+void BasicActivationFunction<T>::applyInPlace(Activation activation, T* values, int count) {
+    kernel(activation)(values, count);
+}
+
+template<typename T>
+typename BasicActivationFunction<T>::Kernel BasicActivationFunction<T>::kernel(Activation activation) {
+    if constexpr (std::is_same_v<T, float>) {
+        const auto index = static_cast<std::size_t>(activation);
+        switch (getAccuracy()) {
+            case ActivationAccuracy::Fast:
+                return simdKernels().fast[index];
+            case ActivationAccuracy::UltraFast:
+                return simdKernels().ultraFast[index];
+            case ActivationAccuracy::Exact:
+                if (activation == Activation::ReLU || activation == Activation::LeakyReLU) {
+                    // ReLU variants involve no approximation.
+                    return simdKernels().fast[index];
+                }
+                break;
+        }
+    }
+
+    switch (activation) {
+        case Activation::Sigmoid:
+            return sigmoidExact<T>;
+        case Activation::Tanh:
+            return tanhExact<T>;
+        case Activation::ReLU:
+            return reluExact<T>;
+        case Activation::LeakyReLU:
+            return leakyReluExact<T>;
+        case Activation::GELU:
+            return geluExact<T>;
+        case Activation::Softmax:
+            return softmaxExact<T>;
+    }
+    return nullptr;
+}
+
+template<typename T>
+void BasicActivationFunction<T>::backwardInPlace(
+    Activation activation, const T* inputs, const T* outputs, T* gradients, int count
+) {
+    switch (activation) {
+        case Activation::Sigmoid:
+            for (int i = 0; i < count; ++i) {
+                gradients[i] *= outputs[i] * (T(1) - outputs[i]);
+            }
+            break;
+        case Activation::Tanh:
+            for (int i = 0; i < count; ++i) {
+                gradients[i] *= T(1) - outputs[i] * outputs[i];
+            }
+            break;
+        case Activation::ReLU:
+            for (int i = 0; i < count; ++i) {
+                gradients[i] = inputs[i] > T(0) ? gradients[i] : T(0);
+            }
+            break;
+        case Activation::LeakyReLU:
+            for (int i = 0; i < count; ++i) {
+                gradients[i] *= inputs[i] > T(0) ? T(1) : LEAKY_RELU_SLOPE;
+            }
+            break;
+        case Activation::GELU:
+            // d/dx x * Phi(x) = Phi(x) + x * phi(x)
+            for (int i = 0; i < count; ++i) {
+                const T x = inputs[i];
+                const T cdf = T(0.5) * (T(1) + std::erf(x * T(0.70710678118654752)));
+                const T pdf = T(0.39894228040143268) * std::exp(T(-0.5) * x * x);
+                gradients[i] *= cdf + x * pdf;
+            }
+            break;
+        case Activation::Softmax: {
+            // Jacobian-vector product: y_i * (g_i - sum_j g_j * y_j)
+            T dot = 0;
+            for (int i = 0; i < count; ++i) {
+                dot += gradients[i] * outputs[i];
+            }
+            for (int i = 0; i < count; ++i) {
+                gradients[i] = outputs[i] * (gradients[i] - dot);
+            }
+            break;
+        }
+    }
+}
+
+template<typename T>
+void BasicActivationFunction<T>::setAccuracy(ActivationAccuracy accuracy) {
+    currentAccuracy.store(accuracy, std::memory_order_relaxed);
+}
+
+template<typename T>
+ActivationAccuracy BasicActivationFunction<T>::getAccuracy() {
+    return currentAccuracy.load(std::memory_order_relaxed);
+}
+
+template class BasicActivationFunction<float>;
+template class BasicActivationFunction<double>;
+
+} // nnn
+
+#undef NNN_DEFINE_ACTIVATION_KERNELS
+#undef NNN_ALWAYS_INLINE
+#undef NNN_ACTIVATION_X86
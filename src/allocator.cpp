@@ -0,0 +1,269 @@
+#include <algorithm>
+#include "allocator.hpp"
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <unordered_map>
+
+namespace nnn {
+
+namespace {
+
+float* alignedNew(std::size_t count) {
+    return static_cast<float*>(::operator new[](count * sizeof(float), std::align_val_t(MATRIX_ALIGNMENT)));
+}
+
+void alignedDelete(float* pointer) {
+    ::operator delete[](pointer, std::align_val_t(MATRIX_ALIGNMENT));
+}
+
+std::size_t classSize(int sizeClass) {
+    return static_cast<std::size_t>(16) << sizeClass;
+}
+
+// Live pools by id, so that thread caches outliving their pool free their blocks instead of returning them.
+// Leaked on purpose: thread caches may be flushed during static destruction.
+struct PoolRegistry {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, PoolAllocator*> pools;
+    std::uint64_t nextId = 1;
+};
+
+PoolRegistry& registry() {
+    static auto* instance = new PoolRegistry();
+    return *instance;
+}
+
+std::atomic<MatrixAllocator*> defaultAllocator{ nullptr };
+thread_local MatrixAllocator* scopedAllocator = nullptr;
+
+} // namespace
+
+MatrixAllocator& MatrixAllocator::current() {
+    MatrixAllocator* scoped = scopedAllocator;
+    return scoped != nullptr ? *scoped : getDefault();
+}
+
+void MatrixAllocator::setDefault(MatrixAllocator* allocator) {
+    defaultAllocator.store(allocator, std::memory_order_release);
+}
+
+MatrixAllocator& MatrixAllocator::getDefault() {
+    MatrixAllocator* allocator = defaultAllocator.load(std::memory_order_acquire);
+    return allocator != nullptr ? *allocator : pool();
+}
+
+MatrixAllocator& MatrixAllocator::pool() {
+    // Never destroyed, so matrices with static storage duration can still release their buffers.
+    static auto* instance = new PoolAllocator();
+    return *instance;
+}
+
+MatrixAllocator& MatrixAllocator::system() {
+    static auto* instance = new SystemAllocator();
+    return *instance;
+}
+
+float* SystemAllocator::allocate(std::size_t count) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytesAllocated.fetch_add(count * sizeof(float), std::memory_order_relaxed);
+    return alignedNew(count);
+}
+
+void SystemAllocator::deallocate(float* pointer, std::size_t) {
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+    alignedDelete(pointer);
+}
+
+AllocationStats SystemAllocator::stats() const {
+    AllocationStats result;
+    result.allocations = allocations.load(std::memory_order_relaxed);
+    result.deallocations = deallocations.load(std::memory_order_relaxed);
+    result.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+    result.systemAllocations = result.allocations;
+    return result;
+}
+
+struct PoolAllocator::ThreadCache {
+    PoolAllocator* owner;
+    std::uint64_t ownerId;
+    std::vector<float*> bins[CLASS_COUNT];
+
+    ~ThreadCache() {
+        PoolRegistry& pools = registry();
+        std::lock_guard lock(pools.mutex);
+        const bool ownerAlive = pools.pools.contains(ownerId);
+        for (int c = 0; c < CLASS_COUNT; ++c) {
+            if (ownerAlive) {
+                owner->returnBlocks(c, bins[c], 0);
+            } else {
+                std::for_each(bins[c].begin(), bins[c].end(), alignedDelete);
+            }
+        }
+    }
+};
+
+PoolAllocator::PoolAllocator() : id([] {
+    PoolRegistry& pools = registry();
+    std::lock_guard lock(pools.mutex);
+    return pools.nextId++;
+}()) {
+    PoolRegistry& pools = registry();
+    std::lock_guard lock(pools.mutex);
+    pools.pools.emplace(id, this);
+}
+
+PoolAllocator::~PoolAllocator() {
+    {
+        PoolRegistry& pools = registry();
+        std::lock_guard lock(pools.mutex);
+        pools.pools.erase(id);
+    }
+    for (std::vector<float*>& blocks : shared) {
+        std::for_each(blocks.begin(), blocks.end(), alignedDelete);
+    }
+}
+
+int PoolAllocator::sizeClass(std::size_t count) {
+    if (count <= 16) {
+        return 0;
+    }
+    const int sizeClass = static_cast<int>(std::bit_width(count - 1)) - 4;
+    return sizeClass < CLASS_COUNT ? sizeClass : -1;
+}
+
+PoolAllocator::ThreadCache& PoolAllocator::threadCache() {
+    thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+    for (const std::unique_ptr<ThreadCache>& cache : caches) {
+        if (cache->ownerId == id) {
+            return *cache;
+        }
+    }
+    auto cache = std::make_unique<ThreadCache>();
+    cache->owner = this;
+    cache->ownerId = id;
+    caches.push_back(std::move(cache));
+    return *caches.back();
+}
+
+void PoolAllocator::returnBlocks(int sizeClass, std::vector<float*>& blocks, std::size_t keep) {
+    if (blocks.size() <= keep) {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    shared[sizeClass].insert(shared[sizeClass].end(), blocks.begin() + static_cast<std::ptrdiff_t>(keep), blocks.end());
+    blocks.resize(keep);
+}
+
+float* PoolAllocator::allocate(std::size_t count) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytesAllocated.fetch_add(count * sizeof(float), std::memory_order_relaxed);
+
+    const int c = sizeClass(count);
+    if (c < 0) {
+        systemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return alignedNew(count);
+    }
+
+    std::vector<float*>& bin = threadCache().bins[c];
+    if (bin.empty()) {
+        // Refill half a cache's worth from the shared list in one lock.
+        std::lock_guard lock(mutex);
+        std::vector<float*>& source = shared[c];
+        const std::size_t take = std::min(source.size(), THREAD_CACHE_LIMIT / 2);
+        bin.insert(bin.end(), source.end() - static_cast<std::ptrdiff_t>(take), source.end());
+        source.resize(source.size() - take);
+    }
+    if (!bin.empty()) {
+        poolHits.fetch_add(1, std::memory_order_relaxed);
+        float* block = bin.back();
+        bin.pop_back();
+        return block;
+    }
+
+    systemAllocations.fetch_add(1, std::memory_order_relaxed);
+    return alignedNew(classSize(c));
+}
+
+void PoolAllocator::deallocate(float* pointer, std::size_t count) {
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+
+    const int c = sizeClass(count);
+    if (c < 0) {
+        alignedDelete(pointer);
+        return;
+    }
+
+    std::vector<float*>& bin = threadCache().bins[c];
+    bin.push_back(pointer);
+    if (bin.size() > THREAD_CACHE_LIMIT) {
+        returnBlocks(c, bin, THREAD_CACHE_LIMIT / 2);
+    }
+}
+
+AllocationStats PoolAllocator::stats() const {
+    AllocationStats result;
+    result.allocations = allocations.load(std::memory_order_relaxed);
+    result.deallocations = deallocations.load(std::memory_order_relaxed);
+    result.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+    result.poolHits = poolHits.load(std::memory_order_relaxed);
+    result.systemAllocations = systemAllocations.load(std::memory_order_relaxed);
+    return result;
+}
+
+void PoolAllocator::trim() {
+    ThreadCache& cache = threadCache();
+    for (int c = 0; c < CLASS_COUNT; ++c) {
+        returnBlocks(c, cache.bins[c], 0);
+    }
+
+    std::lock_guard lock(mutex);
+    for (std::vector<float*>& blocks : shared) {
+        std::for_each(blocks.begin(), blocks.end(), alignedDelete);
+        blocks.clear();
+    }
+}
+
+ArenaScope::ArenaScope(std::size_t blockBytes)
+    : blockSize(std::max<std::size_t>(blockBytes / sizeof(float), 16)), previous(scopedAllocator) {
+    scopedAllocator = this;
+}
+
+ArenaScope::~ArenaScope() {
+    assert(counters.allocations == counters.deallocations && "ArenaScope: a matrix outlived its arena");
+    scopedAllocator = previous;
+    for (const Block& block : blocks) {
+        alignedDelete(block.data);
+    }
+}
+
+float* ArenaScope::allocate(std::size_t count) {
+    ++counters.allocations;
+    counters.bytesAllocated += count * sizeof(float);
+
+    // Keep every allocation on its own cache line.
+    const std::size_t rounded = (count + 15) / 16 * 16;
+    if (blocks.empty() || used + rounded > blocks.back().size) {
+        const std::size_t size = std::max(blockSize, rounded);
+        blocks.push_back({ alignedNew(size), size });
+        used = 0;
+        ++counters.systemAllocations;
+    } else {
+        ++counters.poolHits;
+    }
+
+    float* pointer = blocks.back().data + used;
+    used += rounded;
+    return pointer;
+}
+
+void ArenaScope::deallocate(float*, std::size_t) {
+    ++counters.deallocations;
+}
+
+AllocationStats ArenaScope::stats() const {
+    return counters;
+}
+
+} // nnn
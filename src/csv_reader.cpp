@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include "csv_reader.hpp"
+#include "mapped_file.hpp"
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include "thread_pool.hpp"
+#include <vector>
+
+namespace nnn {
+
+namespace {
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    // Lines in the chunk, blank ones included, and the rows they hold.
+    std::size_t lines = 0;
+    int rows = 0;
+    // 1-based number of the first line, and index of the first row.
+    std::size_t firstLine = 0;
+    int firstRow = 0;
+    // First parse error in the chunk, if any.
+    std::size_t errorLine = 0;
+    std::string error{};
+};
+
+struct Layout {
+    MappedFile file;
+    std::vector<Chunk> chunks{};
+    int rows = 0;
+};
+
+const char* findLineEnd(const char* position, const char* end) {
+    const auto* newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+    return newline != nullptr ? newline : end;
+}
+
+// Drops the '\r' of a "\r\n" line ending.
+const char* trimLineEnd(const char* begin, const char* end) {
+    return end > begin && end[-1] == '\r' ? end - 1 : end;
+}
+
+bool isBlank(char c, char delimiter) {
+    return (c == ' ' || c == '\t') && c != delimiter;
+}
+
+bool isBlankLine(const char* begin, const char* end) {
+    return std::all_of(begin, end, [](char c) { return c == ' ' || c == '\t' || c == '\r'; });
+}
+
+const char* skipBlanks(const char* position, const char* end, char delimiter) {
+    while (position != end && isBlank(*position, delimiter)) {
+        ++position;
+    }
+    return position;
+}
+
+// Maps the file and splits everything after the header into chunks of whole lines, then counts their lines
+// and rows in parallel so that each chunk knows where its rows go.
+Layout split(const std::string& path, const CsvOptions& options) {
+    Layout layout{ MappedFile(path) };
+    const char* begin = reinterpret_cast<const char*>(layout.file.data());
+    const char* end = begin + layout.file.size();
+    std::size_t firstLine = 1;
+    if (options.header && begin != end) {
+        const char* headerEnd = findLineEnd(begin, end);
+        begin = headerEnd == end ? end : headerEnd + 1;
+        firstLine = 2;
+    }
+
+    const std::size_t bytes = end - begin;
+    const std::size_t count = std::clamp<std::size_t>(
+        bytes / CsvReader::CHUNK_BYTES, 1, static_cast<std::size_t>(ThreadPool::getThreadCount()) * 4
+    );
+    const char* chunkBegin = begin;
+    for (std::size_t i = 1; i <= count; ++i) {
+        const char* chunkEnd = end;
+        if (i < count) {
+            chunkEnd = std::max(begin + bytes * i / count, chunkBegin);
+            chunkEnd = findLineEnd(chunkEnd, end);
+            chunkEnd = chunkEnd == end ? end : chunkEnd + 1;
+        }
+        layout.chunks.push_back({ chunkBegin, chunkEnd });
+        chunkBegin = chunkEnd;
+    }
+
+    ThreadPool::parallelFor(static_cast<int>(layout.chunks.size()), 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            Chunk& chunk = layout.chunks[i];
+            for (const char* line = chunk.begin; line != chunk.end;) {
+                const char* lineEnd = findLineEnd(line, chunk.end);
+                ++chunk.lines;
+                chunk.rows += isBlankLine(line, lineEnd) ? 0 : 1;
+                line = lineEnd == chunk.end ? lineEnd : lineEnd + 1;
+            }
+        }
+    });
+
+    for (Chunk& chunk : layout.chunks) {
+        chunk.firstLine = firstLine;
+        chunk.firstRow = layout.rows;
+        firstLine += chunk.lines;
+        layout.rows += chunk.rows;
+    }
+
+    return layout;
+}
+
+int countFields(const Layout& layout, char delimiter) {
+    for (const Chunk& chunk : layout.chunks) {
+        for (const char* line = chunk.begin; line != chunk.end;) {
+            const char* lineEnd = findLineEnd(line, chunk.end);
+            if (!isBlankLine(line, lineEnd)) {
+                return static_cast<int>(std::count(line, lineEnd, delimiter)) + 1;
+            }
+            line = lineEnd == chunk.end ? lineEnd : lineEnd + 1;
+        }
+    }
+
+    return 0;
+}
+
+// Parses one line into `row` of each destination, filling their columns in order. Returns an error message
+// and sets `column` (1-based) on malformed input, or returns an empty string.
+std::string parseLine(const char* position, const char* end, char delimiter, std::span<Matrix* const> destinations, int row, int& column) {
+    column = 0;
+    int expected = 0;
+    for (const Matrix* matrix : destinations) {
+        expected += matrix->getCols();
+    }
+
+    for (Matrix* matrix : destinations) {
+        float* values = matrix->rowData(row);
+        for (int j = 0; j < matrix->getCols(); ++j) {
+            ++column;
+            if (column > 1) {
+                if (position == end || *position != delimiter) {
+                    return "expected " + std::to_string(expected) + " fields, found " + std::to_string(column - 1);
+                }
+                ++position;
+            }
+
+            position = skipBlanks(position, end, delimiter);
+            // `from_chars` rejects an explicit plus sign.
+            if (position != end && *position == '+') {
+                ++position;
+            }
+            const auto [next, error] = std::from_chars(position, end, values[j]);
+            if (error != std::errc()) {
+                const auto* fieldEnd = static_cast<const char*>(std::memchr(position, delimiter, end - position));
+                const std::string_view field(position, (fieldEnd != nullptr ? fieldEnd : end) - position);
+                return (error == std::errc::result_out_of_range ? "number out of range `" : "invalid number `")
+                    + std::string(field) + "`";
+            }
+            position = skipBlanks(next, end, delimiter);
+        }
+    }
+
+    if (position != end) {
+        ++column;
+        return *position == delimiter
+            ? "expected " + std::to_string(expected) + " fields, found more"
+            : "unexpected character `" + std::string(1, *position) + "` after a number";
+    }
+
+    return {};
+}
+
+void parse(Layout& layout, std::span<Matrix* const> destinations, const CsvOptions& options, const char* caller, const std::string& path) {
+    ThreadPool::parallelFor(static_cast<int>(layout.chunks.size()), 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            Chunk& chunk = layout.chunks[i];
+            std::size_t lineNumber = chunk.firstLine;
+            int row = chunk.firstRow;
+            for (const char* line = chunk.begin; line != chunk.end; ++lineNumber) {
+                const char* lineEnd = findLineEnd(line, chunk.end);
+                if (!isBlankLine(line, lineEnd)) {
+                    int column = 0;
+                    std::string error = parseLine(
+                        line, trimLineEnd(line, lineEnd), options.delimiter, destinations, row++, column
+                    );
+                    if (!error.empty()) {
+                        chunk.errorLine = lineNumber;
+                        chunk.error = "line " + std::to_string(lineNumber) + ", column " + std::to_string(column) + ": " + error;
+                        break;
+                    }
+                }
+                line = lineEnd == chunk.end ? lineEnd : lineEnd + 1;
+            }
+        }
+    });
+
+    // Chunks are in file order, so the first failed one holds the first error of the file.
+    for (const Chunk& chunk : layout.chunks) {
+        if (chunk.errorLine != 0) {
+            throw std::runtime_error(std::string(caller) + ": `" + path + "` " + chunk.error);
+        }
+    }
+}
+
+void checkRows(const Layout& layout, const Matrix& matrix, const std::string& path) {
+    if (matrix.getRows() != layout.rows) {
+        throw std::runtime_error(
+            "CsvReader::readInto: `" + path + "` has " + std::to_string(layout.rows) + " rows, expected "
+            + std::to_string(matrix.getRows())
+        );
+    }
+}
+
+} // namespace
+
+Matrix CsvReader::read(const std::string& path, const CsvOptions& options) {
+    Layout layout = split(path, options);
+    if (layout.rows == 0) {
+        throw std::runtime_error("CsvReader::read: `" + path + "` has no rows");
+    }
+
+    Matrix out(layout.rows, countFields(layout, options.delimiter));
+    Matrix* destinations[] = { &out };
+    parse(layout, destinations, options, "CsvReader::read", path);
+    return out;
+}
+
+void CsvReader::readInto(Matrix& out, const std::string& path, const CsvOptions& options) {
+    Layout layout = split(path, options);
+    checkRows(layout, out, path);
+
+    Matrix* destinations[] = { &out };
+    parse(layout, destinations, options, "CsvReader::readInto", path);
+}
+
+void CsvReader::readInto(Matrix& inputs, Matrix& targets, const std::string& path, const CsvOptions& options) {
+    Layout layout = split(path, options);
+    checkRows(layout, inputs, path);
+    checkRows(layout, targets, path);
+
+    Matrix* destinations[] = { &inputs, &targets };
+    parse(layout, destinations, options, "CsvReader::readInto", path);
+}
+
+} // nnn
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "dataset.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace nnn {
+
+namespace {
+
+constexpr std::uint64_t BLOCK_ALIGNMENT = 64;
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+}
+
+std::uint64_t blockBytes(std::uint64_t rows, std::uint32_t stride) {
+    return rows * stride * sizeof(float);
+}
+
+// Whether `rows` rows of `stride` floats starting at `offset` lie within `fileSize` bytes, without overflowing.
+bool blockFits(std::uint64_t offset, std::uint64_t rows, std::uint32_t stride, std::uint64_t fileSize) {
+    return offset <= fileSize && (stride == 0 || rows <= (fileSize - offset) / sizeof(float) / stride);
+}
+
+void writeBlock(std::ofstream& stream, const Matrix& matrix, int stride) {
+    std::vector<float> row(stride, 0.f);
+    for (int i = 0; i < matrix.getRows(); ++i) {
+        std::copy_n(matrix.rowData(i), matrix.getCols(), row.data());
+        stream.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)));
+    }
+}
+
+void writePadding(std::ofstream& stream, std::uint64_t written) {
+    const char zeros[BLOCK_ALIGNMENT] = {};
+    stream.write(zeros, static_cast<std::streamsize>(alignUp(written) - written));
+}
+
+} // namespace
+
+Dataset::Dataset(const std::string& path) : file(path) {
+    if (file.size() < sizeof(DatasetHeader)) {
+        throw std::runtime_error("Dataset::Dataset: `" + path + "` is too small to be a dataset");
+    }
+    std::memcpy(&header, file.data(), sizeof(DatasetHeader));
+    if (std::memcmp(header.magic, DatasetHeader::MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Dataset::Dataset: `" + path + "` is not a dataset file");
+    }
+    if (header.version != DatasetHeader::VERSION) {
+        throw std::runtime_error("Dataset::Dataset: `" + path + "` has unsupported version " + std::to_string(header.version));
+    }
+    // Only the layout `save` writes is accepted, and every size must fit the `int` indices of the views, padded
+    // strides included.
+    constexpr std::uint32_t MAX_SIZE = INT_MAX - Matrix::STRIDE_ALIGNMENT;
+    if (header.rows > INT_MAX || header.inputSize > MAX_SIZE || header.outputSize > MAX_SIZE
+        || header.inputStride != static_cast<std::uint32_t>(Matrix::strideFor(static_cast<int>(header.inputSize)))
+        || header.outputStride != static_cast<std::uint32_t>(Matrix::strideFor(static_cast<int>(header.outputSize)))
+        || header.inputOffset % BLOCK_ALIGNMENT != 0 || header.outputOffset % BLOCK_ALIGNMENT != 0
+        || !blockFits(header.inputOffset, header.rows, header.inputStride, file.size())
+        || !blockFits(header.outputOffset, header.rows, header.outputStride, file.size())) {
+        throw std::runtime_error("Dataset::Dataset: `" + path + "` has an inconsistent header or is truncated");
+    }
+}
+
+void Dataset::save(const std::string& path, const Matrix& inputs, const Matrix& targets) {
+    if (inputs.getRows() != targets.getRows()) {
+        throw std::runtime_error("Dataset::save: inputs and targets must have the same number of rows");
+    }
+
+    DatasetHeader header{};
+    std::memcpy(header.magic, DatasetHeader::MAGIC, sizeof(header.magic));
+    header.version = DatasetHeader::VERSION;
+    header.inputSize = inputs.getCols();
+    header.outputSize = targets.getCols();
+    header.inputStride = Matrix::strideFor(inputs.getCols());
+    header.outputStride = Matrix::strideFor(targets.getCols());
+    header.rows = inputs.getRows();
+    header.inputOffset = sizeof(DatasetHeader);
+    header.outputOffset = alignUp(header.inputOffset + blockBytes(header.rows, header.inputStride));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("Dataset::save: cannot open `" + path + "` for writing");
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeBlock(stream, inputs, static_cast<int>(header.inputStride));
+    writePadding(stream, header.inputOffset + blockBytes(header.rows, header.inputStride));
+    writeBlock(stream, targets, static_cast<int>(header.outputStride));
+    if (!stream) {
+        throw std::runtime_error("Dataset::save: writing `" + path + "` failed");
+    }
+}
+
+int Dataset::getRows() const {
+    return static_cast<int>(header.rows);
+}
+
+int Dataset::getInputSize() const {
+    return static_cast<int>(header.inputSize);
+}
+
+int Dataset::getOutputSize() const {
+    return static_cast<int>(header.outputSize);
+}
+
+Matrix Dataset::inputs(int begin, int end) const {
+    return block(header.inputOffset, getInputSize(), static_cast<int>(header.inputStride), begin, end);
+}
+
+Matrix Dataset::targets(int begin, int end) const {
+    return block(header.outputOffset, getOutputSize(), static_cast<int>(header.outputStride), begin, end);
+}
+
+void Dataset::prefetch(int begin, int end) const {
+    begin = std::clamp(begin, 0, getRows());
+    end = std::clamp(end, begin, getRows());
+    file.prefetch(header.inputOffset + blockBytes(begin, header.inputStride), blockBytes(end - begin, header.inputStride));
+    file.prefetch(header.outputOffset + blockBytes(begin, header.outputStride), blockBytes(end - begin, header.outputStride));
+}
+
+Matrix Dataset::block(std::uint64_t offset, int cols, int stride, int begin, int end) const {
+    if (begin < 0 || end > getRows() || begin > end) {
+        throw std::runtime_error("Dataset::block: row range out of bounds");
+    }
+    // The mapping is private and writable, so handing out non-const views never modifies the file.
+    auto* data = reinterpret_cast<float*>(const_cast<std::byte*>(file.data()) + offset) + static_cast<std::ptrdiff_t>(begin) * stride;
+    return Matrix::view(data, end - begin, cols, stride);
+}
+
+BatchLoader::BatchLoader(const Dataset& dataset, int batchSize) : dataset(dataset), batchSize(batchSize) {
+    if (batchSize <= 0) {
+        throw std::runtime_error("BatchLoader::BatchLoader: batch size must be positive");
+    }
+    prefetcher = std::thread([this] { prefetchLoop(); });
+    requestPrefetch(0);
+}
+
+BatchLoader::~BatchLoader() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    prefetcher.join();
+}
+
+bool BatchLoader::next(Matrix& inputs, Matrix& targets) {
+    // The previous batch views are rebound rather than assigned to, which would write through them.
+    if (position >= dataset.getRows()) {
+        inputs.reset();
+        targets.reset();
+        reset();
+        return false;
+    }
+
+    const int end = std::min(position + batchSize, dataset.getRows());
+    inputs.rebind(dataset.inputs(position, end));
+    targets.rebind(dataset.targets(position, end));
+    position = end;
+    requestPrefetch(position < dataset.getRows() ? position : 0);
+    return true;
+}
+
+void BatchLoader::reset() {
+    position = 0;
+    requestPrefetch(0);
+}
+
+void BatchLoader::requestPrefetch(int begin) {
+    {
+        std::lock_guard lock(mutex);
+        pending = begin;
+    }
+    wake.notify_one();
+}
+
+void BatchLoader::prefetchLoop() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || pending >= 0; });
+        if (stopping) {
+            return;
+        }
+        const int begin = pending;
+        pending = -1;
+        lock.unlock();
+        dataset.prefetch(begin, begin + batchSize);
+        lock.lock();
+    }
+}
+
+} // nnn
@@ -0,0 +1,692 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include "gemm.hpp"
+#include <new>
+#include "profiler.hpp"
+#include "scalar_traits.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NNN_GEMM_X86
+#endif
+
+namespace nnn {
+
+namespace {
+
+// Blocking parameters (Goto/BLIS scheme): a KC x NR sliver of packed B stays in L1,
+// an MC x KC block of packed A in L2 and a KC x NC panel of packed B in L3.
+// MC and NC must be multiples of every micro-kernel's MR and NR respectively.
+constexpr int MC = 144;
+constexpr int KC = 256;
+constexpr int NC = 3072;
+constexpr int MAX_MR = 6;
+constexpr int MAX_NR = 32;
+
+// Below this many multiply-adds packing costs more than it saves.
+constexpr long long SMALL_PRODUCT = 32 * 32 * 32;
+// Below this many multiply-adds the product runs on the calling thread only.
+constexpr long long PARALLEL_PRODUCT = 128 * 128 * 128;
+// Tile edge of the blocked transpose.
+constexpr int TRANSPOSE_BLOCK = 32;
+// Parallel output tiles are multiples of these, which are multiples of every micro-kernel's MR and NR.
+constexpr int TILE_ROW_UNIT = 24;
+constexpr int TILE_COL_UNIT = 64;
+
+// Computes an MR x NR tile of C from packed panels: `a` holds kc columns of MR values, `b` kc rows of NR values.
+using MicroKernel = void (*)(int kc, const float* a, const float* b, float* c, int ldc, bool accumulate);
+
+struct KernelInfo {
+    int mr;
+    int nr;
+    MicroKernel run;
+};
+
+void scalarKernel(int kc, const float* a, const float* b, float* c, int ldc, bool accumulate) {
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    float acc[MR][NR] = {};
+
+    for (int p = 0; p < kc; ++p) {
+        for (int i = 0; i < MR; ++i) {
+            const float ai = a[i];
+            for (int j = 0; j < NR; ++j) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (int i = 0; i < MR; ++i) {
+        float* row = c + static_cast<std::ptrdiff_t>(i) * ldc;
+        for (int j = 0; j < NR; ++j) {
+            row[j] = accumulate ? row[j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+#ifdef NNN_GEMM_X86
+
+__attribute__((target("avx2,fma")))
+void avx2Kernel(int kc, const float* a, const float* b, float* c, int ldc, bool accumulate) {
+    constexpr int MR = 6;
+    __m256 acc[MR][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < MR; ++i) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; ++p) {
+        const __m256 b0 = _mm256_load_ps(b);
+        const __m256 b1 = _mm256_load_ps(b + 8);
+#pragma GCC unroll 6
+        for (int i = 0; i < MR; ++i) {
+            const __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += 16;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < MR; ++i) {
+        float* row = c + static_cast<std::ptrdiff_t>(i) * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, acc[i][0]);
+        _mm256_storeu_ps(row + 8, acc[i][1]);
+    }
+}
+
+__attribute__((target("avx512f")))
+void avx512Kernel(int kc, const float* a, const float* b, float* c, int ldc, bool accumulate) {
+    constexpr int MR = 6;
+    __m512 acc[MR][2];
+#pragma GCC unroll 6
+    for (int i = 0; i < MR; ++i) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; ++p) {
+        const __m512 b0 = _mm512_load_ps(b);
+        const __m512 b1 = _mm512_load_ps(b + 16);
+#pragma GCC unroll 6
+        for (int i = 0; i < MR; ++i) {
+            const __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += 32;
+    }
+
+#pragma GCC unroll 6
+    for (int i = 0; i < MR; ++i) {
+        float* row = c + static_cast<std::ptrdiff_t>(i) * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(row));
+            acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(row + 16));
+        }
+        _mm512_storeu_ps(row, acc[i][0]);
+        _mm512_storeu_ps(row + 16, acc[i][1]);
+    }
+}
+
+#endif
+
+KernelInfo kernelInfo(GemmKernel kernel) {
+    switch (kernel) {
+#ifdef NNN_GEMM_X86
+        case GemmKernel::Avx512:
+            return { 6, 32, avx512Kernel };
+        case GemmKernel::Avx2:
+            return { 6, 16, avx2Kernel };
+#endif
+        default:
+            return { 4, 8, scalarKernel };
+    }
+}
+
+bool cpuSupports(GemmKernel kernel) {
+    switch (kernel) {
+        case GemmKernel::Auto:
+        case GemmKernel::Scalar:
+            return true;
+#ifdef NNN_GEMM_X86
+        case GemmKernel::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case GemmKernel::Avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+GemmKernel detectKernel() {
+    if (cpuSupports(GemmKernel::Avx512)) {
+        return GemmKernel::Avx512;
+    }
+    if (cpuSupports(GemmKernel::Avx2)) {
+        return GemmKernel::Avx2;
+    }
+    return GemmKernel::Scalar;
+}
+
+std::atomic<GemmKernel> forcedKernel{ GemmKernel::Auto };
+
+// Cache-line aligned scratch space for packed panels, grown on demand and reused across calls.
+class PackBuffer {
+public:
+    PackBuffer() = default;
+    PackBuffer(const PackBuffer&) = delete;
+    PackBuffer& operator=(const PackBuffer&) = delete;
+    ~PackBuffer() {
+        ::operator delete[](data, std::align_val_t(64));
+    }
+
+    float* reserve(std::size_t count) {
+        if (count > capacity) {
+            ::operator delete[](data, std::align_val_t(64));
+            data = static_cast<float*>(::operator new[](count * sizeof(float), std::align_val_t(64)));
+            capacity = count;
+        }
+        return data;
+    }
+
+private:
+    float* data = nullptr;
+    std::size_t capacity = 0;
+};
+
+// A GEMM operand as the engine reads it: element (i, j) is at `data + i * rowStep + j * colStep`, which
+// describes both a row-major matrix and the transpose of one without copying it.
+struct Operand {
+    const float* data;
+    std::ptrdiff_t rowStep;
+    std::ptrdiff_t colStep;
+
+    Operand(const float* data, int ld, Transpose transpose)
+        : data(data),
+          rowStep(transpose == Transpose::No ? ld : 1),
+          colStep(transpose == Transpose::No ? 1 : ld) {}
+
+    [[nodiscard]] const float* at(int row, int col) const {
+        return data + row * rowStep + col * colStep;
+    }
+
+    [[nodiscard]] Operand offset(int row, int col) const {
+        Operand result = *this;
+        result.data = at(row, col);
+        return result;
+    }
+};
+
+// Packs an mc x kc block of A into row panels of height mr, zero-padding the last panel.
+void packA(int mc, int kc, const Operand& a, int mr, float* dst) {
+    for (int i = 0; i < mc; i += mr) {
+        const int rows = std::min(mr, mc - i);
+        for (int p = 0; p < kc; ++p) {
+            const float* src = a.at(i, p);
+            int r = 0;
+            if (a.rowStep == 1) {
+                // Transposed A: the panel's rows are contiguous.
+                std::copy_n(src, rows, dst);
+                r = rows;
+            }
+            for (; r < rows; ++r) {
+                dst[r] = src[r * a.rowStep];
+            }
+            for (; r < mr; ++r) {
+                dst[r] = 0.f;
+            }
+            dst += mr;
+        }
+    }
+}
+
+// Packs a kc x nc panel of B into column slivers of width nr, zero-padding the last sliver.
+void packB(int kc, int nc, const Operand& b, int nr, float* dst) {
+    for (int j = 0; j < nc; j += nr) {
+        const int cols = std::min(nr, nc - j);
+        if (b.colStep == 1) {
+            for (int p = 0; p < kc; ++p) {
+                std::copy_n(b.at(p, j), cols, dst);
+                std::fill(dst + cols, dst + nr, 0.f);
+                dst += nr;
+            }
+            continue;
+        }
+        // Transposed B: walk each column of the sliver along its contiguous K run.
+        for (int jj = 0; jj < cols; ++jj) {
+            const float* src = b.at(0, j + jj);
+            for (int p = 0; p < kc; ++p) {
+                dst[p * nr + jj] = src[p * b.rowStep];
+            }
+        }
+        for (int p = 0; p < kc; ++p) {
+            std::fill(dst + p * nr + cols, dst + (p + 1) * nr, 0.f);
+        }
+        dst += static_cast<std::ptrdiff_t>(kc) * nr;
+    }
+}
+
+// Applies the epilogue to a rows x cols tile of C whose first column is output column `col`.
+void applyEpilogue(const GemmEpilogue& epilogue, float* c, int ldc, int rows, int cols, int col) {
+    for (int r = 0; r < rows; ++r) {
+        float* row = c + static_cast<std::ptrdiff_t>(r) * ldc;
+        if (epilogue.bias != nullptr) {
+            const float* bias = epilogue.bias + col;
+            for (int j = 0; j < cols; ++j) {
+                row[j] += bias[j];
+            }
+        }
+        if (epilogue.activation != nullptr) {
+            epilogue.activation(row, cols);
+        }
+    }
+}
+
+bool hasEpilogue(const GemmEpilogue& epilogue) {
+    return epilogue.bias != nullptr || epilogue.activation != nullptr;
+}
+
+void multiplySmall(
+    int m, int n, int k,
+    const Operand& a,
+    const Operand& b,
+    float* c, int ldc,
+    const GemmEpilogue& epilogue
+) {
+    const bool epilogueNeeded = hasEpilogue(epilogue);
+    for (int i = 0; i < m; ++i) {
+        float* cRow = c + static_cast<std::ptrdiff_t>(i) * ldc;
+        if (b.colStep == 1) {
+            std::fill_n(cRow, n, 0.f);
+            for (int p = 0; p < k; ++p) {
+                const float aip = *a.at(i, p);
+                const float* bRow = b.at(p, 0);
+                for (int j = 0; j < n; ++j) {
+                    cRow[j] += aip * bRow[j];
+                }
+            }
+        } else {
+            // Transposed B: each output is a dot product with a contiguous row of the stored B.
+            for (int j = 0; j < n; ++j) {
+                const float* bColumn = b.at(0, j);
+                float sum = 0.f;
+                for (int p = 0; p < k; ++p) {
+                    sum += *a.at(i, p) * bColumn[p * b.rowStep];
+                }
+                cRow[j] = sum;
+            }
+        }
+        if (epilogueNeeded) {
+            applyEpilogue(epilogue, cRow, ldc, 1, n, 0);
+        }
+    }
+}
+
+void multiplyBlocked(
+    const KernelInfo& kernel,
+    int m, int n, int k,
+    const Operand& a,
+    const Operand& b,
+    float* c, int ldc,
+    const GemmEpilogue& epilogue
+) {
+    thread_local PackBuffer bufferA;
+    thread_local PackBuffer bufferB;
+
+    const bool epilogueNeeded = hasEpilogue(epilogue);
+    const int mr = kernel.mr;
+    const int nr = kernel.nr;
+    const int panelWidth = std::min(NC, (n + nr - 1) / nr * nr);
+    float* packedA = bufferA.reserve(static_cast<std::size_t>(MC) * KC);
+    float* packedB = bufferB.reserve(static_cast<std::size_t>(KC) * panelWidth);
+
+    for (int jc = 0; jc < n; jc += NC) {
+        const int nc = std::min(NC, n - jc);
+
+        for (int pc = 0; pc < k; pc += KC) {
+            const int kc = std::min(KC, k - pc);
+            const bool accumulate = pc > 0;
+            const bool lastBlock = pc + kc >= k;
+            packB(kc, nc, b.offset(pc, jc), nr, packedB);
+
+            for (int ic = 0; ic < m; ic += MC) {
+                const int mc = std::min(MC, m - ic);
+                packA(mc, kc, a.offset(ic, pc), mr, packedA);
+
+                for (int jr = 0; jr < nc; jr += nr) {
+                    const int cols = std::min(nr, nc - jr);
+                    const float* panelB = packedB + static_cast<std::ptrdiff_t>(jr) * kc;
+
+                    for (int ir = 0; ir < mc; ir += mr) {
+                        const int rows = std::min(mr, mc - ir);
+                        const float* panelA = packedA + static_cast<std::ptrdiff_t>(ir) * kc;
+                        float* tileC = c + static_cast<std::ptrdiff_t>(ic + ir) * ldc + jc + jr;
+
+                        if (rows == mr && cols == nr) {
+                            kernel.run(kc, panelA, panelB, tileC, ldc, accumulate);
+                        } else {
+                            // Edge tile: compute the full tile into scratch and copy back the valid part.
+                            alignas(64) float tile[MAX_MR * MAX_NR];
+                            kernel.run(kc, panelA, panelB, tile, nr, false);
+                            for (int r = 0; r < rows; ++r) {
+                                float* row = tileC + static_cast<std::ptrdiff_t>(r) * ldc;
+                                for (int j = 0; j < cols; ++j) {
+                                    row[j] = accumulate ? row[j] + tile[r * nr + j] : tile[r * nr + j];
+                                }
+                            }
+                        }
+
+                        if (lastBlock && epilogueNeeded) {
+                            applyEpilogue(epilogue, tileC, ldc, rows, cols, jc + jr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Splits C into a grid of output tiles and runs each as an independent blocked product over the full K.
+// Every element of C is accumulated by the same micro-kernel in the same order as in the serial product,
+// so results do not depend on the thread count.
+void multiplyParallel(
+    const KernelInfo& kernel,
+    int m, int n, int k,
+    const Operand& a,
+    const Operand& b,
+    float* c, int ldc,
+    const GemmEpilogue& epilogue
+) {
+    // A few tiles per thread: rows first, since a row tile reuses the whole packed B panel.
+    const int wanted = 4 * ThreadPool::getThreadCount();
+    const int rowTiles = std::min((m + TILE_ROW_UNIT - 1) / TILE_ROW_UNIT, wanted);
+    const int colTiles = std::min((n + TILE_COL_UNIT - 1) / TILE_COL_UNIT, (wanted + rowTiles - 1) / rowTiles);
+    const int tileRows = ((m + rowTiles - 1) / rowTiles + TILE_ROW_UNIT - 1) / TILE_ROW_UNIT * TILE_ROW_UNIT;
+    const int tileCols = ((n + colTiles - 1) / colTiles + TILE_COL_UNIT - 1) / TILE_COL_UNIT * TILE_COL_UNIT;
+    const int gridRows = (m + tileRows - 1) / tileRows;
+    const int gridCols = (n + tileCols - 1) / tileCols;
+
+    ThreadPool::parallelFor(gridRows * gridCols, 1, [&](int begin, int end) {
+        for (int tile = begin; tile < end; ++tile) {
+            const int row = tile / gridCols * tileRows;
+            const int col = tile % gridCols * tileCols;
+            GemmEpilogue tileEpilogue = epilogue;
+            if (tileEpilogue.bias != nullptr) {
+                tileEpilogue.bias += col;
+            }
+            multiplyBlocked(
+                kernel,
+                std::min(tileRows, m - row), std::min(tileCols, n - col), k,
+                a.offset(row, 0),
+                b.offset(0, col),
+                c + static_cast<std::ptrdiff_t>(row) * ldc + col, ldc,
+                tileEpilogue
+            );
+        }
+    });
+}
+
+// B = A^T in TRANSPOSE_BLOCK x TRANSPOSE_BLOCK tiles: the rows read and the rows written both stay in L1 across
+// a tile.
+template<typename T>
+void transposeBlocked(int rows, int cols, const T* a, int lda, T* b, int ldb) {
+    NNN_PROFILE_SCOPE("transpose");
+    NNN_PROFILE_COUNT(Bytes, 2 * sizeof(T) * static_cast<std::size_t>(rows) * cols);
+    const int rowBlocks = (rows + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    const int grain = std::max(1, ThreadPool::ELEMENTWISE_GRAIN / std::max(1, TRANSPOSE_BLOCK * cols));
+    ThreadPool::parallelFor(rowBlocks, grain, [&](int begin, int end) {
+        for (int block = begin; block < end; ++block) {
+            const int i0 = block * TRANSPOSE_BLOCK;
+            const int i1 = std::min(rows, i0 + TRANSPOSE_BLOCK);
+            for (int j0 = 0; j0 < cols; j0 += TRANSPOSE_BLOCK) {
+                const int j1 = std::min(cols, j0 + TRANSPOSE_BLOCK);
+                for (int i = i0; i < i1; ++i) {
+                    const T* src = a + static_cast<std::ptrdiff_t>(i) * lda;
+                    for (int j = j0; j < j1; ++j) {
+                        b[static_cast<std::ptrdiff_t>(j) * ldb + i] = src[j];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Portable GEMM for element types without a dedicated engine. Transposed operands are packed row-major first.
+// Blocks of PORTABLE_MR rows of C are spread over the thread pool, and each PORTABLE_MR x W register tile,
+// W being the type's SIMD width, accumulates over all of K before it is stored; the fixed-width inner loop is
+// what the compiler vectorizes.
+constexpr int PORTABLE_MR = 4;
+
+template<typename T>
+void multiplyPortable(
+    Transpose transposeA, Transpose transposeB,
+    int m, int n, int k,
+    const T* a, int lda,
+    const T* b, int ldb,
+    T* c, int ldc,
+    const BasicGemmEpilogue<T>& epilogue
+) {
+    NNN_PROFILE_SCOPE("gemm");
+    NNN_PROFILE_COUNT(Flops, 2. * m * n * k);
+    NNN_PROFILE_COUNT(Bytes, sizeof(T) * (static_cast<double>(m) * k + static_cast<double>(k) * n + static_cast<double>(m) * n));
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+    k = std::max(k, 0);
+
+    std::vector<T> packedA;
+    if (transposeA == Transpose::Yes) {
+        packedA.resize(static_cast<std::size_t>(m) * k);
+        transposeBlocked(k, m, a, lda, packedA.data(), k);
+        a = packedA.data();
+        lda = k;
+    }
+    std::vector<T> packedB;
+    if (transposeB == Transpose::Yes) {
+        packedB.resize(static_cast<std::size_t>(k) * n);
+        transposeBlocked(n, k, b, ldb, packedB.data(), n);
+        b = packedB.data();
+        ldb = n;
+    }
+
+    constexpr int W = ScalarTraits<T>::SIMD_WIDTH;
+    const int rowBlocks = (m + PORTABLE_MR - 1) / PORTABLE_MR;
+    const long long blockWork = std::max(1LL, static_cast<long long>(PORTABLE_MR) * n * k);
+    const int grain = static_cast<int>(std::clamp(PARALLEL_PRODUCT / blockWork, 1LL, static_cast<long long>(rowBlocks)));
+    ThreadPool::parallelFor(rowBlocks, grain, [&](int begin, int end) {
+        for (int block = begin; block < end; ++block) {
+            const int i0 = block * PORTABLE_MR;
+            const int rows = std::min(PORTABLE_MR, m - i0);
+            for (int j0 = 0; j0 < n; j0 += W) {
+                const int cols = std::min(W, n - j0);
+                T acc[PORTABLE_MR][W] = {};
+                for (int p = 0; p < k; ++p) {
+                    const T* bRow = b + static_cast<std::ptrdiff_t>(p) * ldb + j0;
+                    for (int r = 0; r < rows; ++r) {
+                        const T value = a[static_cast<std::ptrdiff_t>(i0 + r) * lda + p];
+                        if (cols == W) {
+                            for (int j = 0; j < W; ++j) {
+                                acc[r][j] += value * bRow[j];
+                            }
+                        } else {
+                            for (int j = 0; j < cols; ++j) {
+                                acc[r][j] += value * bRow[j];
+                            }
+                        }
+                    }
+                }
+                for (int r = 0; r < rows; ++r) {
+                    std::copy_n(acc[r], cols, c + static_cast<std::ptrdiff_t>(i0 + r) * ldc + j0);
+                }
+            }
+
+            for (int r = 0; r < rows; ++r) {
+                T* row = c + static_cast<std::ptrdiff_t>(i0 + r) * ldc;
+                if (epilogue.bias != nullptr) {
+                    for (int j = 0; j < n; ++j) {
+                        row[j] += epilogue.bias[j];
+                    }
+                }
+                if (epilogue.activation != nullptr) {
+                    epilogue.activation(row, n);
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+void Gemm::multiply(int m, int n, int k, const float* a, int lda, const float* b, int ldb, float* c, int ldc) {
+    multiply(m, n, k, a, lda, b, ldb, c, ldc, GemmEpilogue{});
+}
+
+void Gemm::multiply(
+    int m, int n, int k,
+    const float* a, int lda,
+    const float* b, int ldb,
+    float* c, int ldc,
+    const GemmEpilogue& epilogue
+) {
+    multiply(Transpose::No, Transpose::No, m, n, k, a, lda, b, ldb, c, ldc, epilogue);
+}
+
+void Gemm::multiply(
+    Transpose transposeA, Transpose transposeB,
+    int m, int n, int k,
+    const float* a, int lda,
+    const float* b, int ldb,
+    float* c, int ldc,
+    const GemmEpilogue& epilogue
+) {
+    NNN_PROFILE_SCOPE("gemm");
+    NNN_PROFILE_COUNT(Flops, 2. * m * n * k);
+    NNN_PROFILE_COUNT(Bytes, sizeof(float) * (static_cast<double>(m) * k + static_cast<double>(k) * n + static_cast<double>(m) * n));
+    const Operand left(a, lda, transposeA);
+    const Operand right(b, ldb, transposeB);
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+    if (k <= 0) {
+        for (int i = 0; i < m; ++i) {
+            std::fill_n(c + static_cast<std::ptrdiff_t>(i) * ldc, n, 0.f);
+        }
+        if (hasEpilogue(epilogue)) {
+            applyEpilogue(epilogue, c, ldc, m, n, 0);
+        }
+        return;
+    }
+
+    if (static_cast<long long>(m) * n * k <= SMALL_PRODUCT) {
+        multiplySmall(m, n, k, left, right, c, ldc, epilogue);
+        return;
+    }
+
+    const KernelInfo kernel = kernelInfo(activeKernel());
+    if (static_cast<long long>(m) * n * k >= PARALLEL_PRODUCT && ThreadPool::getThreadCount() > 1) {
+        multiplyParallel(kernel, m, n, k, left, right, c, ldc, epilogue);
+        return;
+    }
+    multiplyBlocked(kernel, m, n, k, left, right, c, ldc, epilogue);
+}
+
+void Gemm::multiplyBatched(
+    int batch, int m, int n, int k,
+    const float* a, int lda, std::ptrdiff_t strideA,
+    const float* b, int ldb, std::ptrdiff_t strideB,
+    float* c, int ldc, std::ptrdiff_t strideC,
+    const GemmEpilogue& epilogue, std::ptrdiff_t strideBias
+) {
+    if (batch <= 0) {
+        return;
+    }
+    // Small entries are grouped so that each task carries about as much work as one parallel product.
+    const long long product = std::max(1LL, static_cast<long long>(m) * n * k);
+    const int grain = static_cast<int>(std::clamp(PARALLEL_PRODUCT / product, 1LL, static_cast<long long>(batch)));
+    ThreadPool::parallelFor(batch, grain, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            GemmEpilogue entryEpilogue = epilogue;
+            if (entryEpilogue.bias != nullptr) {
+                entryEpilogue.bias += i * strideBias;
+            }
+            multiply(m, n, k, a + i * strideA, lda, b + i * strideB, ldb, c + i * strideC, ldc, entryEpilogue);
+        }
+    });
+}
+
+void Gemm::transpose(int rows, int cols, const float* a, int lda, float* b, int ldb) {
+    transposeBlocked(rows, cols, a, lda, b, ldb);
+}
+
+void Gemm::multiply(int m, int n, int k, const double* a, int lda, const double* b, int ldb, double* c, int ldc) {
+    multiplyPortable(Transpose::No, Transpose::No, m, n, k, a, lda, b, ldb, c, ldc, BasicGemmEpilogue<double>{});
+}
+
+void Gemm::multiply(
+    int m, int n, int k,
+    const double* a, int lda,
+    const double* b, int ldb,
+    double* c, int ldc,
+    const BasicGemmEpilogue<double>& epilogue
+) {
+    multiplyPortable(Transpose::No, Transpose::No, m, n, k, a, lda, b, ldb, c, ldc, epilogue);
+}
+
+void Gemm::multiply(
+    Transpose transposeA, Transpose transposeB,
+    int m, int n, int k,
+    const double* a, int lda,
+    const double* b, int ldb,
+    double* c, int ldc,
+    const BasicGemmEpilogue<double>& epilogue
+) {
+    multiplyPortable(transposeA, transposeB, m, n, k, a, lda, b, ldb, c, ldc, epilogue);
+}
+
+void Gemm::transpose(int rows, int cols, const double* a, int lda, double* b, int ldb) {
+    transposeBlocked(rows, cols, a, lda, b, ldb);
+}
+
+bool Gemm::setKernel(GemmKernel kernel) {
+    if (!cpuSupports(kernel)) {
+        return false;
+    }
+    forcedKernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+GemmKernel Gemm::activeKernel() {
+    static const GemmKernel detected = detectKernel();
+    const GemmKernel forced = forcedKernel.load(std::memory_order_relaxed);
+    return forced == GemmKernel::Auto ? detected : forced;
+}
+
+const char* Gemm::kernelName(GemmKernel kernel) {
+    switch (kernel) {
+        case GemmKernel::Auto:
+            return "auto";
+        case GemmKernel::Scalar:
+            return "scalar";
+        case GemmKernel::Avx2:
+            return "avx2";
+        case GemmKernel::Avx512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+} // nnn
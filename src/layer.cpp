@@ -1,40 +1,156 @@
 #include "activation_function.hpp"
+#include "gemm.hpp"
 #include "layer.hpp"
+#include "thread_pool.hpp"
 
 using namespace nnn;
 
-Layer::Layer() = default;
+template<typename T>
+BasicLayer<T>::BasicLayer() = default;
 
-Layer::Layer(int inputSize, int outputSize) : weights(inputSize, outputSize), biases(1, outputSize) {}
+template<typename T>
+BasicLayer<T>::BasicLayer(int inputSize, int outputSize, Activation activation)
+    : weights(inputSize, outputSize), biases(1, outputSize), activation(activation) {}
 
-Layer::Layer(const Layer& other) {
+template<typename T>
+BasicLayer<T>::BasicLayer(Matrix weights, Matrix biases, Activation activation)
+    : weights(std::move(weights)), biases(std::move(biases)), activation(activation) {}
+
+template<typename T>
+BasicLayer<T>::BasicLayer(const BasicLayer& other) {
     weights = other.weights;
     biases = other.biases;
+    activation = other.activation;
 }
 
-Layer::Layer(Layer&& other) noexcept : weights(std::move(other.weights)), biases(std::move(other.biases)) {}
+template<typename T>
+BasicLayer<T>::BasicLayer(BasicLayer&& other) noexcept
+    : weights(std::move(other.weights)), biases(std::move(other.biases)), activation(other.activation) {}
 
-Layer& Layer::operator=(const Layer& other) {
+template<typename T>
+BasicLayer<T>& BasicLayer<T>::operator=(const BasicLayer& other) {
     if (this != &other) {
         weights = other.weights;
         biases = other.biases;
+        activation = other.activation;
     }
 
     return *this;
 }
 
-Layer& Layer::operator=(Layer&& other) noexcept {
+template<typename T>
+BasicLayer<T>& BasicLayer<T>::operator=(BasicLayer&& other) {
     weights = std::move(other.weights);
     biases = std::move(other.biases);
+    activation = other.activation;
 
     return *this;
 }
 
-Matrix Layer::forward(const Matrix &input) const {
-    return ActivationFunction::sigmoid(input * weights + biases);
+template<typename T>
+BasicMatrix<T> BasicLayer<T>::forward(const Matrix& input) const {
+    Matrix output;
+    forwardInto(input, output);
+    return output;
+}
+
+template<typename T>
+void BasicLayer<T>::forwardInto(const Matrix& input, Matrix& output) const {
+    if (input.getCols() != weights.getRows()) {
+        throw std::runtime_error("Layer::forward: input columns do not match layer input size");
+    }
+    if (&input == &output) {
+        throw std::runtime_error("Layer::forwardInto: output must not alias input");
+    }
+
+    // Bias broadcast and activation run in the GEMM epilogue, so the product is the only buffer written.
+    // Softmax needs whole rows, so it runs as a separate pass over the finished output.
+    const bool rowWise = activation == Activation::Softmax;
+    output.resize(input.getRows(), weights.getCols());
+    Gemm::multiply(
+        input.getRows(), weights.getCols(), weights.getRows(),
+        input.data(), input.getStride(),
+        weights.data(), weights.getStride(),
+        output.data(), output.getStride(),
+        BasicGemmEpilogue<T>{ biases.data(), rowWise ? nullptr : BasicActivationFunction<T>::kernel(activation) }
+    );
+    if (rowWise) {
+        ThreadPool::parallelForRows(output.getRows(), output.getCols(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                BasicActivationFunction<T>::applyInPlace(activation, output.rowData(i), output.getCols());
+            }
+        });
+    }
+}
+
+template<typename T>
+void BasicLayer<T>::randomize(T low, T high) {
+    Random random = Random::global();
+    randomize(low, high, random);
+}
+
+template<typename T>
+void BasicLayer<T>::randomize(T low, T high, Random& random) {
+    weights.randomize(low, high, random);
+    biases.randomize(low, high, random);
+}
+
+template<typename T>
+const BasicMatrix<T>& BasicLayer<T>::forwardTraining(const Matrix& input) {
+    if (input.getCols() != weights.getRows()) {
+        throw std::runtime_error("Layer::forwardTraining: input columns do not match layer input size");
+    }
+
+    // The pre-activations are kept for the backward pass, so the activation runs as a separate pass.
+    cachedInput = &input;
+    preActivations.resize(input.getRows(), weights.getCols());
+    Gemm::multiply(
+        input.getRows(), weights.getCols(), weights.getRows(),
+        input.data(), input.getStride(),
+        weights.data(), weights.getStride(),
+        preActivations.data(), preActivations.getStride(),
+        BasicGemmEpilogue<T>{ biases.data(), nullptr }
+    );
+    BasicActivationFunction<T>::applyInto(activation, outputs, preActivations);
+    return outputs;
 }
 
-void Layer::randomize(float low, float high) {
-    weights.randomize(low, high);
-    biases.randomize(low, high);
+template<typename T>
+void BasicLayer<T>::backward(Matrix& outputGradients, Matrix& weightGradients, Matrix& biasGradients, Matrix* inputGradients) {
+    if (cachedInput == nullptr) {
+        throw std::runtime_error("Layer::backward: there is no forward pass to backpropagate through");
+    }
+    if (outputGradients.getRows() != outputs.getRows() || outputGradients.getCols() != outputs.getCols()) {
+        throw std::runtime_error("Layer::backward: gradients do not match the layer output");
+    }
+
+    const int rows = outputs.getRows();
+    const int cols = outputs.getCols();
+    ThreadPool::parallelForRows(rows, cols, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            BasicActivationFunction<T>::backwardInPlace(
+                activation, preActivations.rowData(i), outputs.rowData(i), outputGradients.rowData(i), cols
+            );
+        }
+    });
+
+    // dW = input^T * dZ, db = column sums of dZ, dX = dZ * W^T; the transposes are read in place.
+    Matrix::multiplyInto(weightGradients, *cachedInput, Transpose::Yes, outputGradients, Transpose::No);
+
+    biasGradients.resize(1, cols);
+    biasGradients.fill(T(0));
+    T* biasGradient = biasGradients.data();
+    for (int i = 0; i < rows; ++i) {
+        const T* gradient = outputGradients.rowData(i);
+        for (int j = 0; j < cols; ++j) {
+            biasGradient[j] += gradient[j];
+        }
+    }
+
+    if (inputGradients != nullptr) {
+        Matrix::multiplyInto(*inputGradients, outputGradients, Transpose::No, weights, Transpose::Yes);
+    }
 }
+
+template class nnn::BasicLayer<float>;
+template class nnn::BasicLayer<double>;
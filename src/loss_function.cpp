@@ -1,20 +1,48 @@
-#include <cmath>
+#include <stdexcept>
 #include "loss_function.hpp"
+#include "profiler.hpp"
 
 using namespace nnn;
 
-float LossFunction::meanSquaredError(const Matrix& predictions, const Matrix& targets) {
+template<typename T>
+T BasicLossFunction<T>::meanSquaredError(const Matrix& predictions, const Matrix& targets) {
+    NNN_PROFILE_SCOPE("loss");
     if (predictions.getCols() != targets.getCols() || predictions.getRows() != targets.getRows()) {
         throw std::runtime_error("LossFunction::meanSquaredError: matrices' dimensions are not equal");
     }
 
-    float result = 0.f;
+    T result = 0;
     for (int i = 0; i < predictions.getRows(); ++i) {
+        const T* predicted = predictions.rowData(i);
+        const T* expected = targets.rowData(i);
         for (int j = 0; j < predictions.getCols(); ++j) {
-            result += std::pow(predictions(i, j) - targets(i, j), 2.f);
+            const T difference = predicted[j] - expected[j];
+            result += difference * difference;
         }
     }
 
-    result /= static_cast<float>(predictions.getCols());
+    result /= static_cast<T>(predictions.getCols());
     return result;
 }
+
+template<typename T>
+void BasicLossFunction<T>::meanSquaredErrorGradient(const Matrix& predictions, const Matrix& targets, Matrix& gradients) {
+    NNN_PROFILE_SCOPE("loss.gradient");
+    if (predictions.getCols() != targets.getCols() || predictions.getRows() != targets.getRows()) {
+        throw std::runtime_error("LossFunction::meanSquaredErrorGradient: matrices' dimensions are not equal");
+    }
+
+    const T scale = T(2) / static_cast<T>(predictions.getCols());
+    gradients.resize(predictions.getRows(), predictions.getCols());
+    for (int i = 0; i < predictions.getRows(); ++i) {
+        const T* predicted = predictions.rowData(i);
+        const T* expected = targets.rowData(i);
+        T* gradient = gradients.rowData(i);
+        for (int j = 0; j < predictions.getCols(); ++j) {
+            gradient[j] = scale * (predicted[j] - expected[j]);
+        }
+    }
+}
+
+template class nnn::BasicLossFunction<float>;
+template class nnn::BasicLossFunction<double>;
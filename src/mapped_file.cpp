@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include "mapped_file.hpp"
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nnn {
+
+MappedFile::MappedFile(const std::string& path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        throw std::runtime_error("MappedFile::MappedFile: cannot open `" + path + "`: " + std::strerror(errno));
+    }
+
+    struct stat status {};
+    if (::fstat(descriptor, &status) != 0) {
+        const int error = errno;
+        ::close(descriptor);
+        throw std::runtime_error("MappedFile::MappedFile: cannot stat `" + path + "`: " + std::strerror(error));
+    }
+
+    length = static_cast<std::size_t>(status.st_size);
+    if (length > 0) {
+        // Writable but private, so that mapped blocks can back non-const Matrix views without touching the file.
+        void* mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            const int error = errno;
+            ::close(descriptor);
+            throw std::runtime_error("MappedFile::MappedFile: cannot map `" + path + "`: " + std::strerror(error));
+        }
+        bytes = static_cast<std::byte*>(mapping);
+    }
+    ::close(descriptor);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : bytes(other.bytes), length(other.length) {
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+std::byte* MappedFile::data() {
+    return bytes;
+}
+
+const std::byte* MappedFile::data() const {
+    return bytes;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t count) const {
+    if (bytes == nullptr || offset >= length) {
+        return;
+    }
+    count = std::min(count, length - offset);
+
+    static const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t begin = offset / pageSize * pageSize;
+    ::madvise(bytes + begin, offset + count - begin, MADV_WILLNEED);
+
+    // One read per page faults the range in.
+    volatile std::byte sink{};
+    for (std::size_t position = begin; position < offset + count; position += pageSize) {
+        sink = bytes[position];
+    }
+    (void) sink;
+}
+
+void MappedFile::unmap() {
+    if (bytes != nullptr) {
+        ::munmap(bytes, length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+} // nnn
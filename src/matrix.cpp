@@ -1,76 +1,97 @@
 #include <algorithm>
-#include <cassert>
+#include "allocator.hpp"
+#include "gemm.hpp"
 #include <iostream>
+#include "profiler.hpp"
 #include "matrix.hpp"
-#include <random>
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include <type_traits>
+#include <utility>
 
 namespace nnn {
 
-Matrix::Matrix() : rows(0), cols(0), data(nullptr) {}
+namespace {
 
-Matrix::Matrix(int rows, int cols) : rows(rows), cols(cols), data(std::make_unique<float[]>(rows * cols)) {
-    std::fill_n(data.get(), rows * cols, 0.f);
+// Allocators hand out float storage; other scalar types are stored in the same buffers, rounded up to whole floats.
+template<typename T>
+std::size_t allocationFloats(std::size_t count) {
+    return (count * sizeof(T) + sizeof(float) - 1) / sizeof(float);
 }
 
-Matrix::Matrix(int rows, int cols, const std::vector<float>& values) : rows(rows), cols(cols) {
+} // namespace
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix() : rows(0), cols(0), values(nullptr), capacity(0), allocator(nullptr), stride(0) {}
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix(int rows, int cols) : BasicMatrix(rows, cols, Uninitialized{}) {
+    fill(T(0));
+}
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix(int rows, int cols, const std::vector<T>& values)
+    : BasicMatrix(rows, cols, Uninitialized{}) {
     if (values.size() != rows * cols) {
         throw std::runtime_error("Matrix::Matrix: `values.size()` should be the same as `rows * cols`");
     }
-    data = std::make_unique<float[]>(rows * cols);
-    std::copy_n(values.begin(), rows * cols, data.get());
+    for (int i = 0; i < rows; ++i) {
+        std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(i) * cols, cols, rowData(i));
+    }
+}
+
+template<typename T>
+BasicMatrix<T>::BasicMatrix(int rows, int cols, Uninitialized)
+    : rows(rows), cols(cols), values(nullptr), capacity(0), allocator(nullptr), stride(strideFor(cols)) {
+    acquire(static_cast<std::size_t>(rows) * stride);
 }
 
-Matrix::Matrix(const Matrix& other) : rows(other.rows), cols(other.cols) {
-    data = std::make_unique<float[]>(rows * cols);
-    std::copy_n(other.data.get(), rows * cols, data.get());
+template<typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other) : BasicMatrix(other.rows, other.cols, Uninitialized{}) {
+    copyFrom(other);
 }
 
-Matrix::Matrix(Matrix&& other) noexcept : rows(other.rows), cols(other.cols), data(std::move(other.data)) {
+template<typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) noexcept
+    : rows(other.rows), cols(other.cols), values(other.values), capacity(other.capacity), allocator(other.allocator),
+      stride(other.stride) {
     other.rows = 0;
     other.cols = 0;
+    other.values = nullptr;
+    other.capacity = 0;
+    other.allocator = nullptr;
+    other.stride = 0;
 }
 
-Matrix& Matrix::operator=(const Matrix& other) {
-    if (this != &other) {
-        if (rows != other.rows || cols != other.cols) {
-            data.reset(new float[other.rows * other.cols]);
-            rows = other.rows;
-            cols = other.cols;
-        }
-        std::copy_n(other.data.get(), rows * cols, data.get());
-    }
-    return *this;
+template<typename T>
+BasicMatrix<T>::~BasicMatrix() {
+    release();
 }
 
-Matrix & Matrix::operator=(Matrix&& other) noexcept {
-    rows = other.rows;
-    cols = other.cols;
-    data = std::move(other.data);
-
-    other.rows = 0;
-    other.cols = 0;
-
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
+    if (this != &other) {
+        resize(other.rows, other.cols);
+        copyFrom(other);
+    }
     return *this;
 }
 
-Matrix Matrix::operator+(const Matrix& other) const {
-    if (cols != other.cols) {
-        throw std::runtime_error("Matrix::operator+: matrix columns do not match");
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) {
+    if (isView()) {
+        return *this = std::as_const(other);
     }
-
-    const int newRows = rows > other.rows ? rows : other.rows;
-    Matrix result(newRows, cols);
-
-    for (int i = 0; i < newRows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            result(i, j) = (*this)(i % rows, j) + other(i % other.rows, j);
-        }
+    if (this != &other) {
+        release();
+        take(other);
     }
 
-    return result;
+    return *this;
 }
 
-Matrix& Matrix::operator+=(const Matrix& other) {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator+=(const BasicMatrix& other) {
     if (cols != other.cols) {
         throw std::runtime_error("Matrix::operator+=: matrix columns do not match");
     }
@@ -81,140 +102,317 @@ Matrix& Matrix::operator+=(const Matrix& other) {
         );
     }
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            (*this)(i, j) += other(i % other.rows, j);
+    // With a shared padded layout whole rows are added: no remainder loop for wide matrices.
+    const int width = sharesLayout(other) ? stride : cols;
+    ThreadPool::parallelForRows(rows, width, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const T* rhs = other.rowData(i % other.rows);
+            T* out = rowData(i);
+            for (int j = 0; j < width; ++j) {
+                out[j] += rhs[j];
+            }
         }
-    }
+    });
 
     return *this;
 }
 
-Matrix Matrix::operator-(const Matrix& other) const {
+template<typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator-=(const BasicMatrix& other) {
     if (rows != other.rows || cols != other.cols) {
-        throw std::runtime_error("Matrix::operator-: matrix dimensions do not match");
+        throw std::runtime_error("Matrix::operator-=: matrix dimensions do not match");
     }
 
-    Matrix result(rows, cols);
-
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            result(i, j) = (*this)(i, j) - other(i, j);
+    // With a shared padded layout whole rows are subtracted, as in operator+=.
+    const int width = sharesLayout(other) ? stride : cols;
+    ThreadPool::parallelForRows(rows, width, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const T* rhs = other.rowData(i);
+            T* out = rowData(i);
+            for (int j = 0; j < width; ++j) {
+                out[j] -= rhs[j];
+            }
         }
+    });
+
+    return *this;
+}
+
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix& other) const {
+    if (cols != other.rows) {
+        throw std::runtime_error("Matrix::operator*: invalid matrix dimensions");
     }
 
+    BasicMatrix result(rows, other.cols, Uninitialized{});
+    Gemm::multiply(rows, other.cols, cols, values, stride, other.values, other.stride, result.values, result.stride);
+
     return result;
 }
 
-Matrix& Matrix::operator-=(const Matrix& other) {
-    if (rows != other.rows || cols != other.cols) {
-        throw std::runtime_error("Matrix::operator-=: matrix dimensions do not match");
+template<typename T>
+void BasicMatrix<T>::multiplyInto(BasicMatrix& out, const BasicMatrix& a, const BasicMatrix& b) {
+    if (a.cols != b.rows) {
+        throw std::runtime_error("Matrix::multiplyInto: invalid matrix dimensions");
     }
-
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            (*this)(i, j) -= other(i, j);
-        }
+    if (&out == &a || &out == &b) {
+        throw std::runtime_error("Matrix::multiplyInto: output must not alias an operand");
     }
 
-    return *this;
+    out.resize(a.rows, b.cols);
+    Gemm::multiply(a.rows, b.cols, a.cols, a.values, a.stride, b.values, b.stride, out.values, out.stride);
 }
 
-Matrix Matrix::operator*(const Matrix& other) const {
-    if (cols != other.rows) {
-        throw std::runtime_error("Matrix::operator*: invalid matrix dimensions");
+template<typename T>
+void BasicMatrix<T>::multiplyInto(
+    BasicMatrix& out, const BasicMatrix& a, Transpose transposeA, const BasicMatrix& b, Transpose transposeB
+) {
+    const int m = transposeA == Transpose::No ? a.rows : a.cols;
+    const int k = transposeA == Transpose::No ? a.cols : a.rows;
+    const int bRows = transposeB == Transpose::No ? b.rows : b.cols;
+    const int n = transposeB == Transpose::No ? b.cols : b.rows;
+    if (k != bRows) {
+        throw std::runtime_error("Matrix::multiplyInto: invalid matrix dimensions");
+    }
+    if (&out == &a || &out == &b) {
+        throw std::runtime_error("Matrix::multiplyInto: output must not alias an operand");
     }
 
-    Matrix result(rows, other.cols);
-    const int n = cols;
+    out.resize(m, n);
+    Gemm::multiply(transposeA, transposeB, m, n, k, a.values, a.stride, b.values, b.stride, out.values, out.stride);
+}
 
-    for (int i = 0; i < result.rows; ++i) {
-        for (int j = 0; j < result.cols; ++j) {
-            result(i, j) = 0.f;
-            for (int k = 0; k < n; ++k) {
-                result(i, j) += (*this)(i, k) * other(k, j);
-            }
-        }
+template<typename T>
+void BasicMatrix<T>::transposeInto(BasicMatrix& out, const BasicMatrix& a) {
+    if (&out == &a) {
+        throw std::runtime_error("Matrix::transposeInto: output must not be the input");
     }
 
-    return result;
+    out.resize(a.cols, a.rows);
+    Gemm::transpose(a.rows, a.cols, a.values, a.stride, out.values, out.stride);
+}
+
+template<typename T>
+void BasicMatrix<T>::evaluate(const TransposeExpression<BasicMatrix>& expression) {
+    const BasicMatrix& source = expression.operand();
+    Gemm::transpose(source.rows, source.cols, source.values, source.stride, values, stride);
 }
 
-Matrix Matrix::operator*(float scalar) const {
-    Matrix result(rows, cols);
+template<typename T>
+void BasicMatrix<T>::addInto(BasicMatrix& out, const BasicMatrix& a, const BasicMatrix& b) {
+    out = a + b;
+}
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            result(i, j) = (*this)(i, j) * scalar;
-        }
+template<typename T>
+BasicMatrix<T> BasicMatrix<T>::view(T* data, int rows, int cols, int stride) {
+    if (stride < cols) {
+        throw std::runtime_error("Matrix::view: stride must not be smaller than the number of columns");
     }
 
+    BasicMatrix result;
+    result.rows = rows;
+    result.cols = cols;
+    result.values = data;
+    result.capacity = static_cast<std::size_t>(rows) * stride;
+    result.stride = stride;
     return result;
 }
 
-
-float Matrix::operator()(int row, int col) const {
-    if (row < 0 || row >= rows) {
-        throw std::runtime_error("Matrix::operator(): row index out of range");
-    }
-    if (col < 0 || col >= cols) {
-        throw std::runtime_error("Matrix::operator(): column index out of range");
+template<typename T>
+void BasicMatrix<T>::rebind(BasicMatrix&& other) noexcept {
+    if (this != &other) {
+        release();
+        take(other);
     }
-    assert(row >= 0 && row < rows && col >= 0 && col < cols);
-    return data[row * cols + col];
 }
 
-float& Matrix::operator()(int row, int col) {
-    if (row < 0 || row >= rows) {
+template<typename T>
+void BasicMatrix<T>::reset() noexcept {
+    release();
+    rows = 0;
+    cols = 0;
+    stride = 0;
+}
+
+// Moves `other`'s state into this matrix, whose storage must already be released.
+template<typename T>
+void BasicMatrix<T>::take(BasicMatrix& other) noexcept {
+    rows = other.rows;
+    cols = other.cols;
+    values = other.values;
+    capacity = other.capacity;
+    allocator = other.allocator;
+    stride = other.stride;
+
+    other.rows = 0;
+    other.cols = 0;
+    other.values = nullptr;
+    other.capacity = 0;
+    other.allocator = nullptr;
+    other.stride = 0;
+}
+
+template<typename T>
+bool BasicMatrix<T>::isView() const {
+    return values != nullptr && allocator == nullptr;
+}
+
+template<typename T>
+void BasicMatrix<T>::throwOutOfRange(bool badRow) {
+    if (badRow) {
         throw std::runtime_error("Matrix::operator(): row index out of range");
     }
-    if (col < 0 || col >= cols) {
-        throw std::runtime_error("Matrix::operator(): column index out of range");
-    }
-    return data[row * cols + col];
+    throw std::runtime_error("Matrix::operator(): column index out of range");
 }
 
-int Matrix::getRows() const {
+template<typename T>
+int BasicMatrix<T>::getRows() const {
     return rows;
 }
 
-int Matrix::getCols() const {
+template<typename T>
+int BasicMatrix<T>::getCols() const {
     return cols;
 }
 
-Matrix Matrix::transposed() const {
-    Matrix result(cols, rows);
+template<typename T>
+int BasicMatrix<T>::getStride() const {
+    return stride;
+}
+
+template<typename T>
+int BasicMatrix<T>::strideFor(int cols) {
+    if (cols < PADDING_THRESHOLD) {
+        return cols;
+    }
+    return (cols + STRIDE_ALIGNMENT - 1) / STRIDE_ALIGNMENT * STRIDE_ALIGNMENT;
+}
+
+template<typename T>
+void BasicMatrix<T>::resize(int rows, int cols) {
+    if (rows == this->rows && cols == this->cols) {
+        return;
+    }
+    if (isView()) {
+        throw std::runtime_error("Matrix::resize: a view cannot change its shape");
+    }
+    const int stride = strideFor(cols);
+    const std::size_t required = static_cast<std::size_t>(rows) * stride;
+    const bool reshaped = stride != this->stride;
+    this->rows = rows;
+    this->cols = cols;
+    this->stride = stride;
+    if (required > capacity) {
+        release();
+        acquire(required);
+    } else if (reshaped) {
+        clearPadding();
+    }
+}
+
+template<typename T>
+void BasicMatrix<T>::fill(T value) {
+    if (hasPaddedLayout()) {
+        std::fill_n(values, static_cast<std::size_t>(rows) * stride, value);
+        return;
+    }
     for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            result(j, i) = (*this)(i, j);
-        }
+        std::fill_n(rowData(i), cols, value);
     }
-    return result;
 }
 
-void Matrix::fill(float value) {
-    std::fill_n(data.get(), rows * cols, value);
+template<typename T>
+void BasicMatrix<T>::acquire(std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+    NNN_PROFILE_COUNT(MatrixAllocations, 1);
+    NNN_PROFILE_COUNT(MatrixBytes, count * sizeof(T));
+    allocator = &MatrixAllocator::current();
+    values = reinterpret_cast<T*>(allocator->allocate(allocationFloats<T>(count)));
+    capacity = count;
+    clearPadding();
+}
+
+template<typename T>
+bool BasicMatrix<T>::hasPaddedLayout() const {
+    return stride == strideFor(cols);
 }
 
-void Matrix::randomize(float low, float high) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution dis(low, high);
+template<typename T>
+bool BasicMatrix<T>::sharesLayout(const BasicMatrix& other) const {
+    return hasPaddedLayout() && stride == other.stride;
+}
 
+// Copies the elements of a same-shaped matrix, padding included when both use the padded layout.
+template<typename T>
+void BasicMatrix<T>::copyFrom(const BasicMatrix& other) {
+    if (sharesLayout(other)) {
+        std::copy_n(other.values, static_cast<std::size_t>(rows) * stride, values);
+        return;
+    }
     for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            (*this)(i, j) = dis(gen);
+        std::copy_n(other.rowData(i), cols, rowData(i));
+    }
+}
+
+// Padding takes part in whole-row kernels, so it is kept finite: recycled buffers may hold anything.
+template<typename T>
+void BasicMatrix<T>::clearPadding() {
+    if (stride == cols) {
+        return;
+    }
+    for (int i = 0; i < rows; ++i) {
+        std::fill(rowData(i) + cols, rowData(i) + stride, T(0));
+    }
+}
+
+template<typename T>
+void BasicMatrix<T>::release() {
+    if (allocator != nullptr) {
+        allocator->deallocate(reinterpret_cast<float*>(values), allocationFloats<T>(capacity));
+    }
+    values = nullptr;
+    capacity = 0;
+    allocator = nullptr;
+}
+
+template<typename T>
+void BasicMatrix<T>::randomize(T low, T high) {
+    Random random = Random::global();
+    randomize(low, high, random);
+}
+
+template<typename T>
+void BasicMatrix<T>::randomize(T low, T high, Random& random) {
+    if constexpr (std::is_same_v<T, float>) {
+        if (stride == cols) {
+            random.fillUniform(span(), low, high);
+            return;
+        }
+        for (int i = 0; i < rows; ++i) {
+            random.fillUniform(rowSpan(i), low, high);
+        }
+    } else {
+        for (int i = 0; i < rows; ++i) {
+            for (T& value : rowSpan(i)) {
+                value = low + (high - low) * static_cast<T>(random.uniform());
+            }
         }
     }
 }
 
-void Matrix::print() const {
+template<typename T>
+void BasicMatrix<T>::print() const {
     for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            std::cout << (*this)(i, j) << ' ';
+        for (const T value : rowSpan(i)) {
+            std::cout << value << ' ';
         }
         std::cout << '\n';
     }
 }
 
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
+
 } // nnn
@@ -1,110 +1,503 @@
 #include <algorithm>
-#include <iostream>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include "dataset.hpp"
+#include <fstream>
 #include "loss_function.hpp"
 #include "neural_network.hpp"
 #include <numeric>
+#include "population.hpp"
+#include "profiler.hpp"
+#include "random.hpp"
+#include <stdexcept>
 
 namespace nnn {
 
-NeuralNetwork::NeuralNetwork(const std::vector<int>& layerSizes) {
+namespace {
+
+// Binary model format, in the host's byte order:
+//   ModelHeader (64 bytes)
+//   one ModelLayer per layer, zero-padded to a 64-byte boundary
+//   the parameter buffer exactly as `NeuralNetwork::getParameters` lays it out, starting at `parameterOffset`
+// That layout depends on how `Matrix::strideFor` pads rows, so the header records its constants and a file
+// is only loaded by builds that pad the same way. The checksum covers everything after the header.
+struct ModelHeader {
+    static constexpr char MAGIC[8] = { 'N', 'N', 'N', 'M', 'O', 'D', 'E', 'L' };
+    static constexpr std::uint32_t VERSION = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t layerCount;
+    std::uint32_t strideAlignment;
+    std::uint32_t paddingThreshold;
+    std::uint64_t parameterCount;
+    std::uint64_t parameterOffset;
+    std::uint64_t checksum;
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(ModelHeader) == 64);
+
+struct ModelLayer {
+    std::uint32_t inputSize;
+    std::uint32_t outputSize;
+    std::uint32_t activation;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(ModelLayer) == 16);
+
+constexpr std::size_t MODEL_ALIGNMENT = 64;
+
+std::size_t alignModelOffset(std::size_t offset) {
+    return (offset + MODEL_ALIGNMENT - 1) / MODEL_ALIGNMENT * MODEL_ALIGNMENT;
+}
+
+// FNV-1a style hash over 64-bit words in four interleaved lanes, so that verifying a large model is bound by
+// memory bandwidth rather than by one multiply per byte. Every block passed to `update` is a multiple of 32
+// bytes long, which the 64-byte aligned sections of the format guarantee.
+class Checksum {
+public:
+    void update(const std::byte* data, std::size_t bytes) {
+        for (std::size_t i = 0; i + 32 <= bytes; i += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                std::uint64_t word;
+                std::memcpy(&word, data + i + lane * 8, sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * PRIME;
+            }
+        }
+    }
+
+    [[nodiscard]] std::uint64_t value() const {
+        std::uint64_t hash = BASIS;
+        for (const std::uint64_t lane : lanes) {
+            hash = (hash ^ lane) * PRIME;
+        }
+        return hash;
+    }
+
+private:
+    static constexpr std::uint64_t BASIS = 0xcbf29ce484222325;
+    static constexpr std::uint64_t PRIME = 0x100000001b3;
+
+    std::uint64_t lanes[4] = { BASIS, BASIS + 1, BASIS + 2, BASIS + 3 };
+};
+
+} // namespace
+
+NeuralNetwork::NeuralNetwork(const std::vector<int>& layerSizes)
+    : NeuralNetwork(
+        layerSizes,
+        std::vector(layerSizes.empty() ? 0 : layerSizes.size() - 1, Activation::Sigmoid)
+    ) {}
+
+NeuralNetwork::NeuralNetwork(const std::vector<int>& layerSizes, const std::vector<Activation>& activations) {
     if (layerSizes.size() < 2) {
         throw std::runtime_error("NeuralNetwork::NeuralNetwork: there must be at least 2 layers");
     }
+    if (activations.size() != layerSizes.size() - 1) {
+        throw std::runtime_error("NeuralNetwork::NeuralNetwork: there must be one activation per weight layer");
+    }
 
+    std::size_t total = 0;
     for (int i = 1; i < layerSizes.size(); ++i) {
-        layers.emplace_back(layerSizes[i - 1], layerSizes[i]);
+        total += parameterCount(layerSizes[i - 1], layerSizes[i]);
+        shapes.push_back({ layerSizes[i - 1], layerSizes[i], activations[i - 1] });
     }
+    parameters = Matrix(1, static_cast<int>(total));
+    bindLayers();
 }
 
-NeuralNetwork::NeuralNetwork(const NeuralNetwork& other) : layers(other.layers) {}
-
-NeuralNetwork::NeuralNetwork(NeuralNetwork&& other) noexcept {
-    layers = std::move(other.layers);
+NeuralNetwork::NeuralNetwork(const NeuralNetwork& other) : parameters(other.parameters), shapes(other.shapes) {
+    bindLayers();
 }
 
+NeuralNetwork::NeuralNetwork(NeuralNetwork&& other) noexcept
+    : layers(std::move(other.layers)), parameters(std::move(other.parameters)), shapes(std::move(other.shapes)),
+      mapping(std::move(other.mapping)) {}
+
 NeuralNetwork& NeuralNetwork::operator=(const NeuralNetwork& other) {
     if (this != &other) {
-        layers = other.layers;
+        // A mapped network's parameters are a view, which assignment would write through; copies own their buffer.
+        if (parameters.isView()) {
+            parameters.reset();
+        }
+        parameters = other.parameters;
+        shapes = other.shapes;
+        mapping = MappedFile();
+        bindLayers();
     }
 
     return *this;
 }
 
 NeuralNetwork& NeuralNetwork::operator=(NeuralNetwork&& other) noexcept {
-    layers = std::move(other.layers);
+    if (this != &other) {
+        layers = std::move(other.layers);
+        parameters.rebind(std::move(other.parameters));
+        shapes = std::move(other.shapes);
+        mapping = std::move(other.mapping);
+    }
+
     return *this;
 }
 
-Matrix NeuralNetwork::predict(const Matrix& input) {
-    Matrix output = input;
-    for (Layer& layer : layers) {
-        output = layer.forward(output);
+std::span<float> NeuralNetwork::getParameters() {
+    return parameters.rowSpan(0);
+}
+
+std::span<const float> NeuralNetwork::getParameters() const {
+    return parameters.rowSpan(0);
+}
+
+void NeuralNetwork::save(const std::string& path) const {
+    ModelHeader header{};
+    std::memcpy(header.magic, ModelHeader::MAGIC, sizeof(header.magic));
+    header.version = ModelHeader::VERSION;
+    header.layerCount = static_cast<std::uint32_t>(shapes.size());
+    header.strideAlignment = Matrix::STRIDE_ALIGNMENT;
+    header.paddingThreshold = Matrix::PADDING_THRESHOLD;
+    header.parameterCount = getParameters().size();
+    header.parameterOffset = alignModelOffset(sizeof(ModelHeader) + shapes.size() * sizeof(ModelLayer));
+
+    // Layer table and its padding, i.e. everything between the header and the parameters.
+    std::vector<std::byte> table(header.parameterOffset - sizeof(ModelHeader));
+    for (std::size_t i = 0; i < shapes.size(); ++i) {
+        const ModelLayer layer{
+            static_cast<std::uint32_t>(shapes[i].inputSize),
+            static_cast<std::uint32_t>(shapes[i].outputSize),
+            static_cast<std::uint32_t>(shapes[i].activation),
+            0,
+        };
+        std::memcpy(table.data() + i * sizeof(ModelLayer), &layer, sizeof(layer));
+    }
+
+    const auto* parameterBytes = reinterpret_cast<const std::byte*>(getParameters().data());
+    const std::size_t parameterSize = getParameters().size_bytes();
+    Checksum checksum;
+    checksum.update(table.data(), table.size());
+    checksum.update(parameterBytes, parameterSize);
+    header.checksum = checksum.value();
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("NeuralNetwork::save: cannot open `" + path + "` for writing");
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size()));
+    stream.write(reinterpret_cast<const char*>(parameterBytes), static_cast<std::streamsize>(parameterSize));
+    if (!stream) {
+        throw std::runtime_error("NeuralNetwork::save: writing `" + path + "` failed");
+    }
+}
+
+NeuralNetwork NeuralNetwork::load(const std::string& path, LoadMode mode, bool verifyChecksum) {
+    MappedFile file(path);
+    const auto fail = [&](const std::string& reason) {
+        throw std::runtime_error("NeuralNetwork::load: `" + path + "` " + reason);
+    };
+
+    ModelHeader header{};
+    if (file.size() < sizeof(header)) {
+        fail("is too small to be a model");
     }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, ModelHeader::MAGIC, sizeof(header.magic)) != 0) {
+        fail("is not a model file");
+    }
+    if (header.version != ModelHeader::VERSION) {
+        fail("has unsupported version " + std::to_string(header.version));
+    }
+    if (header.strideAlignment != Matrix::STRIDE_ALIGNMENT || header.paddingThreshold != Matrix::PADDING_THRESHOLD) {
+        fail("was written with a different parameter layout");
+    }
+    if (header.layerCount == 0
+        || header.parameterOffset != alignModelOffset(sizeof(ModelHeader) + header.layerCount * sizeof(ModelLayer))
+        || header.parameterOffset > file.size()
+        || header.parameterCount > (file.size() - header.parameterOffset) / sizeof(float)) {
+        fail("has an inconsistent header or is truncated");
+    }
+
+    NeuralNetwork network;
+    std::size_t total = 0;
+    for (std::uint32_t i = 0; i < header.layerCount; ++i) {
+        ModelLayer layer{};
+        std::memcpy(&layer, file.data() + sizeof(ModelHeader) + i * sizeof(ModelLayer), sizeof(layer));
+        if (layer.inputSize == 0 || layer.inputSize > INT32_MAX || layer.outputSize == 0 || layer.outputSize > INT32_MAX
+            || layer.activation > static_cast<std::uint32_t>(Activation::Softmax)
+            || (i > 0 && layer.inputSize != static_cast<std::uint32_t>(network.shapes.back().outputSize))) {
+            fail("has an invalid layer " + std::to_string(i));
+        }
+        const int inputSize = static_cast<int>(layer.inputSize);
+        const int outputSize = static_cast<int>(layer.outputSize);
+        network.shapes.push_back({ inputSize, outputSize, static_cast<Activation>(layer.activation) });
+        total += parameterCount(inputSize, outputSize);
+        // Parameters are indexed with `int`; stopping here also keeps the sum from wrapping.
+        if (total > INT_MAX) {
+            fail("has more parameters than a network can hold");
+        }
+    }
+    if (total != header.parameterCount) {
+        fail("has an inconsistent header or is truncated");
+    }
+
+    auto* parameterData = reinterpret_cast<float*>(file.data() + header.parameterOffset);
+    if (verifyChecksum) {
+        Checksum checksum;
+        checksum.update(file.data() + sizeof(ModelHeader), header.parameterOffset - sizeof(ModelHeader));
+        checksum.update(file.data() + header.parameterOffset, total * sizeof(float));
+        if (checksum.value() != header.checksum) {
+            fail("is corrupt: checksum mismatch");
+        }
+    }
+
+    const int count = static_cast<int>(total);
+    switch (mode) {
+        case LoadMode::Copy:
+            network.parameters = Matrix(1, count);
+            std::copy_n(parameterData, total, network.parameters.data());
+            break;
+        case LoadMode::Map:
+            network.parameters = Matrix::view(parameterData, 1, count, Matrix::strideFor(count));
+            network.mapping = std::move(file);
+            break;
+    }
+    network.bindLayers();
+    return network;
+}
+
+std::size_t NeuralNetwork::parameterCount(int inputSize, int outputSize) {
+    const auto alignUp = [](std::size_t count) {
+        return (count + Matrix::STRIDE_ALIGNMENT - 1) / Matrix::STRIDE_ALIGNMENT * Matrix::STRIDE_ALIGNMENT;
+    };
+    const std::size_t stride = Matrix::strideFor(outputSize);
+    return alignUp(static_cast<std::size_t>(inputSize) * stride) + alignUp(stride);
+}
+
+void NeuralNetwork::bindLayers() {
+    layers.resize(shapes.size());
+    float* data = parameters.data();
+    for (std::size_t i = 0; i < shapes.size(); ++i) {
+        const int inputSize = shapes[i].inputSize;
+        const int outputSize = shapes[i].outputSize;
+        const int stride = Matrix::strideFor(outputSize);
+        const std::size_t biasOffset = parameterCount(inputSize, outputSize) - parameterCount(0, outputSize);
+        layers[i].weights.rebind(Matrix::view(data, inputSize, outputSize, stride));
+        layers[i].biases.rebind(Matrix::view(data + biasOffset, 1, outputSize, stride));
+        layers[i].activation = shapes[i].activation;
+        data += parameterCount(inputSize, outputSize);
+    }
+}
+
+Matrix NeuralNetwork::predict(const Matrix& input) {
+    Matrix output;
+    predict(input, output);
     return output;
 }
 
+void NeuralNetwork::predict(const Matrix& input, Matrix& output) {
+    NNN_PROFILE_SCOPE("predict");
+    const Matrix* current = &input;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        NNN_PROFILE_SCOPE("layer.forward", static_cast<int>(i));
+        Matrix& next = i + 1 == layers.size() ? output : activations[i % 2];
+        layers[i].forwardInto(*current, next);
+        current = &next;
+    }
+}
+
 void NeuralNetwork::randomize(float low, float high) {
-    for (Layer& layer : layers) {
-        layer.randomize(low, high);
+    randomize(low, high, Random::global());
+}
+
+void NeuralNetwork::randomize(float low, float high, const Random& random) {
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        Random layerRandom = random.split(i);
+        layers[i].randomize(low, high, layerRandom);
     }
 }
 
 void NeuralNetwork::train(const Matrix &X, const Matrix &Y, int epochs, float learningRate) {
+    train(X, Y, epochs, learningRate, TrainingMode::Genetic);
+}
+
+void NeuralNetwork::train(
+    const Matrix& X, const Matrix& Y, int epochs, float learningRate, TrainingMode mode,
+    OptimizerType optimizer, int batchSize
+) {
+    TrainingOptions options;
+    options.epochs = epochs;
+    options.learningRate = learningRate;
+    options.mode = mode;
+    options.optimizer = optimizer;
+    options.batchSize = batchSize;
+    (void) train(X, Y, options);
+}
+
+void NeuralNetwork::train(const Dataset& dataset, int epochs, float learningRate, OptimizerType optimizer, int batchSize) {
+    TrainingOptions options;
+    options.epochs = epochs;
+    options.learningRate = learningRate;
+    options.optimizer = optimizer;
+    options.batchSize = batchSize;
+    (void) train(dataset, options);
+}
+
+TrainingResult NeuralNetwork::train(const Matrix& X, const Matrix& Y, const TrainingOptions& options) {
+    if (X.getRows() != Y.getRows()) {
+        throw std::runtime_error("NeuralNetwork::train: X and Y must have the same number of rows");
+    }
+
+    switch (options.mode) {
+        case TrainingMode::Genetic:
+            return trainGenetic(X, Y, options);
+        case TrainingMode::Backpropagation:
+            return trainBackpropagation(X, Y, options);
+    }
+    throw std::runtime_error("NeuralNetwork::train: unknown training mode");
+}
+
+TrainingResult NeuralNetwork::trainGenetic(const Matrix& X, const Matrix& Y, const TrainingOptions& options) {
     constexpr int populationSize = 30;
     constexpr float mutationRate = 0.5;
 
-    std::vector<NeuralNetwork> population(populationSize, *this);
+    TrainingMonitor monitor(options, "least loss");
+    Population population(*this, populationSize);
+    std::vector<float> scores(populationSize);
+    std::vector<int> sortedIndices(populationSize);
+    // Every random decision comes from a stream derived from `random`, so training is reproducible for a
+    // given global seed whatever the thread count.
+    const Random random = Random::global();
 
-    for (int epoch = 0; epoch < epochs; ++epoch) {
+    for (int epoch = 0; monitor.shouldContinue(); ++epoch) {
+        NNN_PROFILE_SCOPE("epoch");
 
         // 1. error for each network
-        std::vector<float> scores;
-        for (NeuralNetwork& net : population) {
-            Matrix output = net.predict(X);
-            scores.push_back(LossFunction::meanSquaredError(output, Y));
-        }
+        population.evaluate(X, Y, scores);
 
         // 2. selection
-        std::vector<int> sortedIndices(populationSize);
-        std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
-        std::sort(sortedIndices.begin(), sortedIndices.end(), [&](int a, int b) {
-            return scores[a] < scores[b];
-        });
-
-        std::vector<NeuralNetwork> newPopulation;
-        for (int i = 0; i < populationSize / 2; ++i) {
-            newPopulation.push_back(population[sortedIndices[i]]);
+        {
+            NNN_PROFILE_SCOPE("selection");
+            std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
+            std::sort(sortedIndices.begin(), sortedIndices.end(), [&](int a, int b) {
+                return scores[a] < scores[b];
+            });
         }
 
-        // 3. mutation
-        for (NeuralNetwork& net : newPopulation) {
-            for (Layer& layer : net.layers) {
-                for (int i = 0; i < layer.weights.getRows(); ++i) {
-                    for (int j = 0; j < layer.weights.getCols(); ++j) {
-                        if (static_cast<float>(rand()) / RAND_MAX < mutationRate) {
-                            layer.weights(i, j) += (static_cast<float>(rand()) / RAND_MAX) * 2.f - 1.f;
-                        }
-                    }
-                }
-                for (int j = 0; j < layer.biases.getCols(); ++j) {
-                    if (static_cast<float>(rand()) / RAND_MAX < mutationRate) {
-                        layer.biases(0, j) += (static_cast<float>(rand()) / RAND_MAX) * 2.f - 1.f;
-                    }
-                }
+        // 3. mutation of the better half and 4. fill with copies of the mutated networks
+        Random epochRandom = random.split(epoch);
+        population.breed(std::span(sortedIndices).first(populationSize / 2), mutationRate, epochRandom);
+
+        monitor.endEpoch(scores[sortedIndices[0]]);
+    }
+
+    population.copyTo(0, *this);
+    return monitor.finish();
+}
+
+TrainingResult NeuralNetwork::trainBackpropagation(const Matrix& X, const Matrix& Y, const TrainingOptions& options) {
+    if (options.batchSize <= 0) {
+        throw std::runtime_error("NeuralNetwork::train: batch size must be positive");
+    }
+
+    TrainingMonitor monitor(options, "mean loss");
+    Gradients gradients = makeGradients();
+    Optimizer optimizer(options.optimizer, options.learningRate, getParameters().size());
+    const int samples = X.getRows();
+    const int batchSize = options.batchSize;
+    std::vector<int> order(samples);
+    std::iota(order.begin(), order.end(), 0);
+    Matrix batchX;
+    Matrix batchY;
+    Random random = Random::global();
+
+    while (monitor.shouldContinue()) {
+        NNN_PROFILE_SCOPE("epoch");
+        for (int i = samples - 1; i > 0; --i) {
+            std::swap(order[i], order[random.nextUint() % (i + 1)]);
+        }
+
+        float loss = 0.f;
+        for (int start = 0; start < samples; start += batchSize) {
+            const int count = std::min(batchSize, samples - start);
+            batchX.resize(count, X.getCols());
+            batchY.resize(count, Y.getCols());
+            for (int i = 0; i < count; ++i) {
+                std::copy_n(X.rowData(order[start + i]), X.getCols(), batchX.rowData(i));
+                std::copy_n(Y.rowData(order[start + i]), Y.getCols(), batchY.rowData(i));
             }
+            loss += backpropagate(batchX, batchY, gradients);
+            NNN_PROFILE_SCOPE("optimizer");
+            optimizer.step(getParameters(), gradients.buffer.rowSpan(0));
         }
 
-        // 4. fill
-        population = newPopulation;
-        while (population.size() < populationSize) {
-            population.push_back(population[rand() % (populationSize / 2)]);
+        monitor.endEpoch(loss / static_cast<float>(samples));
+    }
+    return monitor.finish();
+}
+
+TrainingResult NeuralNetwork::train(const Dataset& dataset, const TrainingOptions& options) {
+    if (dataset.getInputSize() != layers.front().weights.getRows() || dataset.getOutputSize() != layers.back().weights.getCols()) {
+        throw std::runtime_error("NeuralNetwork::train: dataset does not match the network architecture");
+    }
+    if (options.mode != TrainingMode::Backpropagation) {
+        throw std::runtime_error("NeuralNetwork::train: datasets only support backpropagation");
+    }
+
+    TrainingMonitor monitor(options, "mean loss");
+    Gradients gradients = makeGradients();
+    Optimizer optimizer(options.optimizer, options.learningRate, getParameters().size());
+    BatchLoader loader(dataset, options.batchSize);
+    Matrix batchX;
+    Matrix batchY;
+
+    while (monitor.shouldContinue()) {
+        NNN_PROFILE_SCOPE("epoch");
+        float loss = 0.f;
+        while (loader.next(batchX, batchY)) {
+            loss += backpropagate(batchX, batchY, gradients);
+            NNN_PROFILE_SCOPE("optimizer");
+            optimizer.step(getParameters(), gradients.buffer.rowSpan(0));
         }
 
-        if (epoch % 25 == 0)
-            std::cout << "Epoch: " << epoch << " - least loss: " << scores[sortedIndices[0]] << '\n';
+        monitor.endEpoch(loss / static_cast<float>(dataset.getRows()));
+    }
+    return monitor.finish();
+}
+
+NeuralNetwork::Gradients NeuralNetwork::makeGradients() const {
+    // Gradients share the parameters' layout, so the optimizer makes one flat pass over both.
+    Gradients gradients;
+    gradients.buffer = Matrix(1, parameters.getCols());
+    for (const Layer& layer : layers) {
+        float* weights = gradients.buffer.data() + (layer.weights.data() - parameters.data());
+        float* biases = gradients.buffer.data() + (layer.biases.data() - parameters.data());
+        gradients.weights.push_back(Matrix::view(weights, layer.weights.getRows(), layer.weights.getCols(), layer.weights.getStride()));
+        gradients.biases.push_back(Matrix::view(biases, 1, layer.biases.getCols(), layer.biases.getStride()));
+    }
+    return gradients;
+}
+
+float NeuralNetwork::backpropagate(const Matrix& X, const Matrix& Y, Gradients& gradients) {
+    NNN_PROFILE_SCOPE("backpropagate");
+    const Matrix* output = &X;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        NNN_PROFILE_SCOPE("layer.forwardTraining", static_cast<int>(i));
+        output = &layers[i].forwardTraining(*output);
     }
+    const float loss = LossFunction::meanSquaredError(*output, Y);
 
-    layers = population[0].layers;
+    // The batch loss is the mean of the per-sample losses.
+    LossFunction::meanSquaredErrorGradient(*output, Y, gradients.deltas[0]);
+    for (float& delta : gradients.deltas[0].span()) {
+        delta /= static_cast<float>(X.getRows());
+    }
+    for (std::size_t i = layers.size(); i-- > 0;) {
+        Matrix& outputGradients = gradients.deltas[(layers.size() - 1 - i) % 2];
+        Matrix* inputGradients = i > 0 ? &gradients.deltas[(layers.size() - i) % 2] : nullptr;
+        NNN_PROFILE_SCOPE("layer.backward", static_cast<int>(i));
+        layers[i].backward(outputGradients, gradients.weights[i], gradients.biases[i], inputGradients);
+    }
+    return loss;
 }
 
 } // nnn
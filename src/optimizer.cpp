@@ -0,0 +1,82 @@
+#include <cmath>
+#include "optimizer.hpp"
+#include <stdexcept>
+#include "thread_pool.hpp"
+
+namespace nnn {
+
+Optimizer::Optimizer(OptimizerType type, float learningRate, std::size_t parameterCount)
+    : type(type), learningRate(learningRate) {
+    if (type != OptimizerType::Sgd) {
+        firstMoments.assign(parameterCount, 0.f);
+    }
+    if (type == OptimizerType::Adam) {
+        secondMoments.assign(parameterCount, 0.f);
+    }
+}
+
+void Optimizer::step(std::span<float> parameters, std::span<const float> gradients) {
+    if (parameters.size() != gradients.size()) {
+        throw std::runtime_error("Optimizer::step: there must be one gradient per parameter");
+    }
+    if (type != OptimizerType::Sgd && parameters.size() != firstMoments.size()) {
+        throw std::runtime_error("Optimizer::step: parameter count does not match the optimizer state");
+    }
+
+    ++steps;
+    const float rate = learningRate;
+    float* p = parameters.data();
+    const float* g = gradients.data();
+    const int count = static_cast<int>(parameters.size());
+
+    switch (type) {
+        case OptimizerType::Sgd:
+            ThreadPool::parallelFor(count, ThreadPool::ELEMENTWISE_GRAIN, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    p[i] -= rate * g[i];
+                }
+            });
+            break;
+        case OptimizerType::Momentum: {
+            float* v = firstMoments.data();
+            ThreadPool::parallelFor(count, ThreadPool::ELEMENTWISE_GRAIN, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    v[i] = MOMENTUM * v[i] + g[i];
+                    p[i] -= rate * v[i];
+                }
+            });
+            break;
+        }
+        case OptimizerType::Adam: {
+            float* m = firstMoments.data();
+            float* v = secondMoments.data();
+            // Bias corrections of both moments folded into the step size and epsilon.
+            const float correction1 = 1.f - std::pow(ADAM_BETA1, static_cast<float>(steps));
+            const float correction2 = 1.f - std::pow(ADAM_BETA2, static_cast<float>(steps));
+            const float stepSize = rate * std::sqrt(correction2) / correction1;
+            const float epsilon = ADAM_EPSILON * std::sqrt(correction2);
+            ThreadPool::parallelFor(count, ThreadPool::ELEMENTWISE_GRAIN, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    m[i] = ADAM_BETA1 * m[i] + (1.f - ADAM_BETA1) * g[i];
+                    v[i] = ADAM_BETA2 * v[i] + (1.f - ADAM_BETA2) * g[i] * g[i];
+                    p[i] -= stepSize * m[i] / (std::sqrt(v[i]) + epsilon);
+                }
+            });
+            break;
+        }
+    }
+}
+
+OptimizerType Optimizer::getType() const {
+    return type;
+}
+
+float Optimizer::getLearningRate() const {
+    return learningRate;
+}
+
+void Optimizer::setLearningRate(float learningRate) {
+    this->learningRate = learningRate;
+}
+
+} // nnn
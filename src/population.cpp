@@ -0,0 +1,201 @@
+#include "activation_function.hpp"
+#include <algorithm>
+#include <array>
+#include "gemm.hpp"
+#include "population.hpp"
+#include "profiler.hpp"
+#include <stdexcept>
+#include "thread_pool.hpp"
+
+namespace nnn {
+
+Population::Population(const NeuralNetwork& prototype, int size) : prototype(prototype) {
+    if (size <= 0) {
+        throw std::runtime_error("Population::Population: size must be positive");
+    }
+
+    const std::span<const float> parameters = prototype.getParameters();
+    for (Matrix& generation : generations) {
+        generation = Matrix(size, static_cast<int>(parameters.size()));
+    }
+    for (int i = 0; i < size; ++i) {
+        std::copy(parameters.begin(), parameters.end(), current().rowData(i));
+    }
+}
+
+int Population::size() const {
+    return current().getRows();
+}
+
+std::size_t Population::parameterCount() const {
+    return current().getCols();
+}
+
+std::span<float> Population::parameters(int individual) {
+    return current().rowSpan(individual);
+}
+
+std::span<const float> Population::parameters(int individual) const {
+    return current().rowSpan(individual);
+}
+
+void Population::evaluate(const Matrix& X, const Matrix& Y, std::span<float> scores) {
+    NNN_PROFILE_SCOPE("population.evaluate");
+    const std::vector<Layer>& layers = prototype.layers;
+    if (scores.size() != static_cast<std::size_t>(size())) {
+        throw std::runtime_error("Population::evaluate: there must be one score per individual");
+    }
+    if (X.getCols() != layers.front().weights.getRows()) {
+        throw std::runtime_error("Population::evaluate: input columns do not match the network input size");
+    }
+    if (Y.getRows() != X.getRows() || Y.getCols() != layers.back().weights.getCols()) {
+        throw std::runtime_error("Population::evaluate: targets do not match the network output");
+    }
+
+    const Matrix& block = current();
+    const int individuals = size();
+    const int samples = X.getRows();
+    const float* layout = prototype.getParameters().data();
+    const auto offsetOf = [&](const Matrix& view) { return view.data() - layout; };
+
+    // Softmax needs whole rows of one individual, so it runs after the product, block by block.
+    const auto finish = [&](Matrix& output, const Layer& layer) {
+        if (layer.activation != Activation::Softmax) {
+            return;
+        }
+        const int width = layer.weights.getCols();
+        ThreadPool::parallelForRows(output.getRows(), output.getCols(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                for (int individual = 0; individual < individuals; ++individual) {
+                    ActivationFunction::applyInPlace(layer.activation, output.rowData(i) + individual * width, width);
+                }
+            }
+        });
+    };
+    const auto epilogueFor = [](const Layer& layer, const float* bias) {
+        return GemmEpilogue{
+            bias, layer.activation == Activation::Softmax ? nullptr : ActivationFunction::kernel(layer.activation)
+        };
+    };
+
+    // 1. first layer: X is shared, so every individual's weights go side by side into one wide product
+    const Layer& first = layers.front();
+    const int inputSize = first.weights.getRows();
+    const int firstWidth = first.weights.getCols();
+    stackedWeights.resize(inputSize, individuals * firstWidth);
+    stackedBiases.resize(1, individuals * firstWidth);
+    ThreadPool::parallelForRows(inputSize, stackedWeights.getCols(), [&](int begin, int end) {
+        for (int r = begin; r < end; ++r) {
+            for (int individual = 0; individual < individuals; ++individual) {
+                const float* source = block.rowData(individual) + offsetOf(first.weights) + r * first.weights.getStride();
+                std::copy_n(source, firstWidth, stackedWeights.rowData(r) + individual * firstWidth);
+            }
+        }
+    });
+    for (int individual = 0; individual < individuals; ++individual) {
+        const float* source = block.rowData(individual) + offsetOf(first.biases);
+        std::copy_n(source, firstWidth, stackedBiases.data() + individual * firstWidth);
+    }
+    outputs[0].resize(samples, individuals * firstWidth);
+    Gemm::multiply(
+        samples, individuals * firstWidth, inputSize,
+        X.data(), X.getStride(),
+        stackedWeights.data(), stackedWeights.getStride(),
+        outputs[0].data(), outputs[0].getStride(),
+        epilogueFor(first, stackedBiases.data())
+    );
+    finish(outputs[0], first);
+
+    // 2. later layers: one product per individual over its column block, with weights read in place
+    for (std::size_t l = 1; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        const Matrix& input = outputs[(l - 1) % 2];
+        Matrix& output = outputs[l % 2];
+        const int width = layer.weights.getCols();
+        output.resize(samples, individuals * width);
+        Gemm::multiplyBatched(
+            individuals, samples, width, layer.weights.getRows(),
+            input.data(), input.getStride(), layer.weights.getRows(),
+            block.data() + offsetOf(layer.weights), layer.weights.getStride(), block.getStride(),
+            output.data(), output.getStride(), width,
+            epilogueFor(layer, block.data() + offsetOf(layer.biases)), block.getStride()
+        );
+        finish(output, layer);
+    }
+
+    // 3. loss, matching LossFunction::meanSquaredError
+    const Matrix& predictions = outputs[(layers.size() - 1) % 2];
+    const int width = Y.getCols();
+    ThreadPool::parallelFor(individuals, 1, [&](int begin, int end) {
+        for (int individual = begin; individual < end; ++individual) {
+            float result = 0.f;
+            for (int i = 0; i < samples; ++i) {
+                const float* predicted = predictions.rowData(i) + individual * width;
+                const float* expected = Y.rowData(i);
+                for (int j = 0; j < width; ++j) {
+                    const float difference = predicted[j] - expected[j];
+                    result += difference * difference;
+                }
+            }
+            scores[individual] = result / static_cast<float>(width);
+        }
+    });
+}
+
+void Population::breed(std::span<const int> parents, float mutationRate, Random& random) {
+    NNN_PROFILE_SCOPE("mutation");
+    if (parents.empty() || parents.size() > static_cast<std::size_t>(size())) {
+        throw std::runtime_error("Population::breed: there must be between 1 and `size()` parents");
+    }
+
+    const Matrix& from = current();
+    Matrix& to = generations[1 - currentGeneration];
+    const std::size_t count = parameterCount();
+    const int offspring = static_cast<int>(parents.size());
+
+    // Mutation is fused with the copy out of the current generation. A parameter is mutated when its first
+    // draw is below the mutation rate, by its second draw. Draws come in chunks of whole Philox blocks, so a
+    // child's stream holds the same values as if it were filled at once, and scratch memory stays constant.
+    constexpr std::size_t CHUNK = 2048;
+    ThreadPool::parallelFor(offspring, 1, [&](int begin, int end) {
+        std::array<float, CHUNK> draw;
+        for (int i = begin; i < end; ++i) {
+            Random childRandom = random.split(i);
+            const float* parent = from.rowData(parents[i]);
+            float* child = to.rowData(i);
+            for (std::size_t first = 0; first < count; first += CHUNK / 2) {
+                const std::size_t chunk = std::min(CHUNK / 2, count - first);
+                childRandom.fillUniform(std::span(draw).first(2 * chunk), 0.f, 1.f);
+                for (std::size_t j = 0; j < chunk; ++j) {
+                    const bool mutated = draw[2 * j] < mutationRate;
+                    child[first + j] = parent[first + j] + (mutated ? draw[2 * j + 1] * 2.f - 1.f : 0.f);
+                }
+            }
+        }
+    });
+
+    for (int i = offspring; i < size(); ++i) {
+        const int source = static_cast<int>(random.nextUint() % offspring);
+        std::copy_n(to.rowData(source), count, to.rowData(i));
+    }
+
+    currentGeneration = 1 - currentGeneration;
+}
+
+void Population::copyTo(int individual, NeuralNetwork& network) const {
+    const std::span<float> parameters = network.getParameters();
+    if (parameters.size() != parameterCount()) {
+        throw std::runtime_error("Population::copyTo: network architecture does not match the population");
+    }
+    std::copy_n(current().rowData(individual), parameters.size(), parameters.data());
+}
+
+Matrix& Population::current() {
+    return generations[currentGeneration];
+}
+
+const Matrix& Population::current() const {
+    return generations[currentGeneration];
+}
+
+} // nnn
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "profiler.hpp"
+#include <stdexcept>
+#include <utility>
+
+namespace nnn {
+
+namespace {
+
+constexpr std::size_t COUNTER_COUNT = 4;
+
+struct TraceEvent {
+    const char* name;
+    int index;
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+};
+
+struct ZoneStats {
+    const char* name;
+    int index;
+    std::uint64_t calls;
+    std::uint64_t totalNs;
+    std::uint64_t maxNs;
+};
+
+// Everything one thread recorded. Only its own thread writes to it; the mutex is uncontended except while
+// a snapshot, trace or reset reads it.
+struct ThreadProfile {
+    std::mutex mutex;
+    int id = 0;
+    // Few distinct zones are entered on a thread, so a linear search by name pointer beats hashing.
+    std::vector<ZoneStats> zones;
+    std::vector<TraceEvent> events;
+    std::uint64_t droppedEvents = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    // Kept alive after their threads exit, so that their zones stay in the snapshot.
+    std::vector<std::shared_ptr<ThreadProfile>> threads;
+    std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters{};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+// Never destroyed, so that pool workers may still record while static objects are torn down at exit.
+Registry& registry() {
+    static Registry* const instance = new Registry;
+    return *instance;
+}
+
+ThreadProfile& threadProfile() {
+    thread_local const std::shared_ptr<ThreadProfile> profile = [] {
+        auto created = std::make_shared<ThreadProfile>();
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        created->id = static_cast<int>(shared.threads.size());
+        shared.threads.push_back(created);
+        return created;
+    }();
+    return *profile;
+}
+
+// Zone names are library literals, but are escaped anyway so that the trace is always valid JSON.
+void writeQuoted(std::ostream& stream, const char* text) {
+    stream << '"';
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            stream << '\\';
+        }
+        stream << *text;
+    }
+    stream << '"';
+}
+
+} // namespace
+
+void Profiler::add(ProfileCounter counter, std::uint64_t value) {
+    if constexpr (ENABLED) {
+        registry().counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::record(const char* name, int index, std::uint64_t startNs, std::uint64_t endNs) {
+    if constexpr (!ENABLED) {
+        return;
+    }
+
+    ThreadProfile& profile = threadProfile();
+    const std::uint64_t duration = endNs - startNs;
+    const std::lock_guard lock(profile.mutex);
+    const auto zone = std::find_if(profile.zones.begin(), profile.zones.end(), [&](const ZoneStats& stats) {
+        return stats.name == name && stats.index == index;
+    });
+    if (zone == profile.zones.end()) {
+        profile.zones.push_back({ name, index, 1, duration, duration });
+    } else {
+        ++zone->calls;
+        zone->totalNs += duration;
+        zone->maxNs = std::max(zone->maxNs, duration);
+    }
+
+    if (profile.events.size() < TRACE_CAPACITY) {
+        profile.events.push_back({ name, index, startNs, duration });
+    } else {
+        ++profile.droppedEvents;
+    }
+}
+
+std::uint64_t Profiler::now() {
+    if constexpr (!ENABLED) {
+        return 0;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+ProfileSnapshot Profiler::snapshot() {
+    ProfileSnapshot snapshot;
+    Registry& shared = registry();
+    snapshot.flops = shared.counters[static_cast<std::size_t>(ProfileCounter::Flops)].load();
+    snapshot.bytes = shared.counters[static_cast<std::size_t>(ProfileCounter::Bytes)].load();
+    snapshot.matrixAllocations = shared.counters[static_cast<std::size_t>(ProfileCounter::MatrixAllocations)].load();
+    snapshot.matrixBytes = shared.counters[static_cast<std::size_t>(ProfileCounter::MatrixBytes)].load();
+
+    // Zones of the same name are merged by content: the same literal may have several addresses.
+    std::map<std::pair<std::string, int>, ProfileZone> merged;
+    const std::lock_guard lock(shared.mutex);
+    for (const std::shared_ptr<ThreadProfile>& thread : shared.threads) {
+        const std::lock_guard threadLock(thread->mutex);
+        snapshot.droppedEvents += thread->droppedEvents;
+        for (const ZoneStats& stats : thread->zones) {
+            ProfileZone& zone = merged[{ stats.name, stats.index }];
+            zone.calls += stats.calls;
+            zone.totalNs += stats.totalNs;
+            zone.maxNs = std::max(zone.maxNs, stats.maxNs);
+        }
+    }
+
+    for (auto& [key, zone] : merged) {
+        zone.name = key.first;
+        zone.index = key.second;
+        snapshot.zones.push_back(std::move(zone));
+    }
+    std::stable_sort(snapshot.zones.begin(), snapshot.zones.end(), [](const ProfileZone& a, const ProfileZone& b) {
+        return a.totalNs > b.totalNs;
+    });
+    return snapshot;
+}
+
+void Profiler::reset() {
+    Registry& shared = registry();
+    for (std::atomic<std::uint64_t>& counter : shared.counters) {
+        counter.store(0);
+    }
+    const std::lock_guard lock(shared.mutex);
+    for (const std::shared_ptr<ThreadProfile>& thread : shared.threads) {
+        const std::lock_guard threadLock(thread->mutex);
+        thread->zones.clear();
+        thread->events.clear();
+        thread->droppedEvents = 0;
+    }
+}
+
+void Profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream stream(path, std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("Profiler::writeChromeTrace: cannot open `" + path + "`");
+    }
+
+    // Complete ("X") events with microsecond timestamps; one trace thread per profiled thread.
+    stream << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+    const char* separator = "\n";
+    {
+        Registry& shared = registry();
+        const std::lock_guard lock(shared.mutex);
+        for (const std::shared_ptr<ThreadProfile>& thread : shared.threads) {
+            const std::lock_guard threadLock(thread->mutex);
+            for (const TraceEvent& event : thread->events) {
+                stream << separator << "{\"name\": ";
+                writeQuoted(stream, event.name);
+                stream << ", \"cat\": \"nnn\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread->id
+                    << ", \"ts\": " << static_cast<double>(event.startNs) / 1e3
+                    << ", \"dur\": " << static_cast<double>(event.durationNs) / 1e3;
+                if (event.index >= 0) {
+                    stream << ", \"args\": {\"index\": " << event.index << '}';
+                }
+                stream << '}';
+                separator = ",\n";
+            }
+        }
+    }
+
+    const ProfileSnapshot counters = snapshot();
+    stream << "\n], \"displayTimeUnit\": \"ns\", \"otherData\": {"
+        << "\"flops\": " << counters.flops
+        << ", \"bytes\": " << counters.bytes
+        << ", \"matrixAllocations\": " << counters.matrixAllocations
+        << ", \"matrixBytes\": " << counters.matrixBytes
+        << ", \"droppedEvents\": " << counters.droppedEvents << "}}\n";
+    if (!stream) {
+        throw std::runtime_error("Profiler::writeChromeTrace: cannot write `" + path + "`");
+    }
+}
+
+} // nnn
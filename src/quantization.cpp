@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include "gemm.hpp"
+#include <immintrin.h>
+#include "quantization.hpp"
+#include <stdexcept>
+#include "thread_pool.hpp"
+
+namespace nnn {
+
+namespace {
+
+// Input rows processed together, so that each channel's weights are loaded once per block.
+constexpr int ROW_BLOCK = 4;
+constexpr float INT8_MAX_VALUE = 127.f;
+
+// sums[r] = dot(x + r * xStride, w) for r < rows, over `length` elements; `length` is a multiple of 16.
+using Int8Kernel = void (*)(const std::int8_t* w, const std::int8_t* x, int xStride, int rows, int length, std::int32_t* sums);
+// Same over 16-bit weights widened to fp32; `x` has no padding, so any `length` is allowed.
+using HalfKernel = void (*)(const std::uint16_t* w, const float* x, int xStride, int rows, int length, float* sums);
+
+void dotInt8Scalar(const std::int8_t* w, const std::int8_t* x, int xStride, int rows, int length, std::int32_t* sums) {
+    for (int r = 0; r < rows; ++r) {
+        const std::int8_t* row = x + static_cast<std::ptrdiff_t>(r) * xStride;
+        std::int32_t sum = 0;
+        for (int k = 0; k < length; ++k) {
+            sum += static_cast<std::int32_t>(row[k]) * w[k];
+        }
+        sums[r] = sum;
+    }
+}
+
+template<float (*widen)(std::uint16_t)>
+void dotHalfScalar(const std::uint16_t* w, const float* x, int xStride, int rows, int length, float* sums) {
+    for (int r = 0; r < rows; ++r) {
+        const float* row = x + static_cast<std::ptrdiff_t>(r) * xStride;
+        float sum = 0.f;
+        for (int k = 0; k < length; ++k) {
+            sum += row[k] * widen(w[k]);
+        }
+        sums[r] = sum;
+    }
+}
+
+__attribute__((target("avx2")))
+std::int32_t horizontalSum(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2")))
+float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+// Sign-extends 16 int8 values to int16 and multiplies adjacent pairs into int32 lanes.
+__attribute__((target("avx2")))
+void dotInt8Avx2(const std::int8_t* w, const std::int8_t* x, int xStride, int rows, int length, std::int32_t* sums) {
+    __m256i acc[ROW_BLOCK];
+    for (__m256i& value : acc) {
+        value = _mm256_setzero_si256();
+    }
+    for (int k = 0; k < length; k += 16) {
+        const __m256i weights = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + k)));
+        for (int r = 0; r < rows; ++r) {
+            const auto* row = x + static_cast<std::ptrdiff_t>(r) * xStride + k;
+            const __m256i inputs = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(inputs, weights));
+        }
+    }
+    for (int r = 0; r < rows; ++r) {
+        sums[r] = horizontalSum(acc[r]);
+    }
+}
+
+template<bool bfloat>
+__attribute__((target("avx2,f16c,fma")))
+void dotHalfAvx2(const std::uint16_t* w, const float* x, int xStride, int rows, int length, float* sums) {
+    __m256 acc[ROW_BLOCK];
+    for (__m256& value : acc) {
+        value = _mm256_setzero_ps();
+    }
+    const int vectorLength = length / 8 * 8;
+    for (int k = 0; k < vectorLength; k += 8) {
+        const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + k));
+        const __m256 weights = bfloat
+            ? _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16))
+            : _mm256_cvtph_ps(bits);
+        for (int r = 0; r < rows; ++r) {
+            const float* row = x + static_cast<std::ptrdiff_t>(r) * xStride + k;
+            acc[r] = _mm256_fmadd_ps(_mm256_loadu_ps(row), weights, acc[r]);
+        }
+    }
+    for (int r = 0; r < rows; ++r) {
+        float sum = horizontalSum(acc[r]);
+        const float* row = x + static_cast<std::ptrdiff_t>(r) * xStride;
+        for (int k = vectorLength; k < length; ++k) {
+            sum += row[k] * (bfloat ? fromBFloat16(w[k]) : fromFloat16(w[k]));
+        }
+        sums[r] = sum;
+    }
+}
+
+// The AVX2 kernels follow the GEMM engine's choice, so forcing the scalar GEMM kernel also forces these.
+bool useAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")
+        && __builtin_cpu_supports("fma");
+    return supported && Gemm::activeKernel() != GemmKernel::Scalar;
+}
+
+} // namespace
+
+// Bit tricks after F. Giesen's float/half conversions: rebias the exponent, and let an fp32 addition do the
+// rounding of subnormal halves.
+std::uint16_t toFloat16(float value) {
+    std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7fffffff;
+
+    if (bits >= 0x47800000) {
+        // Too large for a half, infinity or NaN.
+        return sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (bits < 0x38800000) {
+        // Subnormal half: adding 0.5 aligns the mantissa so that the addition rounds at the half's last bit.
+        const float aligned = std::bit_cast<float>(bits) + 0.5f;
+        return sign | static_cast<std::uint16_t>(std::bit_cast<std::uint32_t>(aligned) - 0x3f000000);
+    }
+    const std::uint32_t odd = (bits >> 13) & 1;
+    bits += 0xc8000fff + odd;
+    return sign | static_cast<std::uint16_t>(bits >> 13);
+}
+
+float fromFloat16(std::uint16_t bits) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000) << 16;
+    std::uint32_t magnitude = static_cast<std::uint32_t>(bits & 0x7fff) << 13;
+    const std::uint32_t exponent = magnitude & 0x0f800000;
+
+    magnitude += 0x38000000;
+    if (exponent == 0x0f800000) {
+        // Infinity or NaN.
+        magnitude += 0x38000000;
+    } else if (exponent == 0) {
+        // Zero or subnormal: renormalize through an fp32 subtraction.
+        magnitude = std::bit_cast<std::uint32_t>(std::bit_cast<float>(magnitude + 0x00800000) - std::bit_cast<float>(0x38800000));
+    }
+    return std::bit_cast<float>(sign | magnitude);
+}
+
+std::uint16_t toBFloat16(float value) {
+    const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        // Keep NaNs quiet rather than letting rounding carry them into infinity.
+        return static_cast<std::uint16_t>((bits >> 16) | 0x0040);
+    }
+    return static_cast<std::uint16_t>((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+}
+
+float fromBFloat16(std::uint16_t bits) {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+}
+
+QuantizedLayer::QuantizedLayer(const Layer& layer, WeightPrecision precision)
+    : precision(precision), activation(layer.activation), inputSize(layer.weights.getRows()),
+      outputSize(layer.weights.getCols()),
+      channelStride((inputSize + CHANNEL_ALIGNMENT - 1) / CHANNEL_ALIGNMENT * CHANNEL_ALIGNMENT),
+      biases(layer.biases.rowData(0), layer.biases.rowData(0) + outputSize) {
+    const std::size_t size = static_cast<std::size_t>(outputSize) * channelStride;
+    switch (precision) {
+        case WeightPrecision::Int8:
+            int8Weights.assign(size, 0);
+            scales.resize(outputSize);
+            for (int j = 0; j < outputSize; ++j) {
+                float maxAbs = 0.f;
+                for (int k = 0; k < inputSize; ++k) {
+                    maxAbs = std::max(maxAbs, std::fabs(layer.weights.rowData(k)[j]));
+                }
+                scales[j] = maxAbs / INT8_MAX_VALUE;
+                const float inverse = maxAbs > 0.f ? INT8_MAX_VALUE / maxAbs : 0.f;
+                std::int8_t* channel = int8Weights.data() + static_cast<std::size_t>(j) * channelStride;
+                for (int k = 0; k < inputSize; ++k) {
+                    channel[k] = static_cast<std::int8_t>(std::nearbyint(layer.weights.rowData(k)[j] * inverse));
+                }
+            }
+            break;
+        case WeightPrecision::Float16:
+        case WeightPrecision::BFloat16:
+            halfWeights.assign(size, 0);
+            for (int j = 0; j < outputSize; ++j) {
+                std::uint16_t* channel = halfWeights.data() + static_cast<std::size_t>(j) * channelStride;
+                for (int k = 0; k < inputSize; ++k) {
+                    const float weight = layer.weights.rowData(k)[j];
+                    channel[k] = precision == WeightPrecision::Float16 ? toFloat16(weight) : toBFloat16(weight);
+                }
+            }
+            break;
+    }
+}
+
+void QuantizedLayer::forwardInto(const Matrix& input, Matrix& output) const {
+    if (input.getCols() != inputSize) {
+        throw std::runtime_error("QuantizedLayer::forwardInto: input columns do not match layer input size");
+    }
+    if (&input == &output) {
+        throw std::runtime_error("QuantizedLayer::forwardInto: output must not alias input");
+    }
+
+    const bool avx2 = useAvx2();
+    const Int8Kernel int8Kernel = avx2 ? dotInt8Avx2 : dotInt8Scalar;
+    const HalfKernel halfKernel = precision == WeightPrecision::Float16
+        ? (avx2 ? dotHalfAvx2<false> : dotHalfScalar<fromFloat16>)
+        : (avx2 ? dotHalfAvx2<true> : dotHalfScalar<fromBFloat16>);
+
+    const int rows = input.getRows();
+    output.resize(rows, outputSize);
+    const int blocks = (rows + ROW_BLOCK - 1) / ROW_BLOCK;
+    const long long blockWork = static_cast<long long>(ROW_BLOCK) * inputSize * outputSize;
+    ThreadPool::parallelForRows(blocks, static_cast<int>(std::min<long long>(blockWork, INT_MAX)), [&](int begin, int end) {
+        // Quantized inputs of one block, padded like the channels; the padding meets zero weights.
+        thread_local std::vector<std::int8_t> quantized;
+        quantized.resize(static_cast<std::size_t>(ROW_BLOCK) * channelStride);
+
+        for (int block = begin; block < end; ++block) {
+            const int first = block * ROW_BLOCK;
+            const int count = std::min(ROW_BLOCK, rows - first);
+
+            if (precision == WeightPrecision::Int8) {
+                float inputScales[ROW_BLOCK];
+                for (int r = 0; r < count; ++r) {
+                    const float* row = input.rowData(first + r);
+                    float maxAbs = 0.f;
+                    for (int k = 0; k < inputSize; ++k) {
+                        maxAbs = std::max(maxAbs, std::fabs(row[k]));
+                    }
+                    inputScales[r] = maxAbs / INT8_MAX_VALUE;
+                    const float inverse = maxAbs > 0.f ? INT8_MAX_VALUE / maxAbs : 0.f;
+                    std::int8_t* target = quantized.data() + static_cast<std::size_t>(r) * channelStride;
+                    for (int k = 0; k < inputSize; ++k) {
+                        target[k] = static_cast<std::int8_t>(std::nearbyint(row[k] * inverse));
+                    }
+                }
+
+                std::int32_t sums[ROW_BLOCK];
+                for (int j = 0; j < outputSize; ++j) {
+                    int8Kernel(int8Weights.data() + static_cast<std::size_t>(j) * channelStride, quantized.data(), channelStride, count, channelStride, sums);
+                    for (int r = 0; r < count; ++r) {
+                        output.rowData(first + r)[j] = static_cast<float>(sums[r]) * inputScales[r] * scales[j] + biases[j];
+                    }
+                }
+            } else {
+                float sums[ROW_BLOCK];
+                for (int j = 0; j < outputSize; ++j) {
+                    halfKernel(halfWeights.data() + static_cast<std::size_t>(j) * channelStride, input.rowData(first), input.getStride(), count, inputSize, sums);
+                    for (int r = 0; r < count; ++r) {
+                        output.rowData(first + r)[j] = sums[r] + biases[j];
+                    }
+                }
+            }
+
+            // The block's outputs are still in cache.
+            for (int r = 0; r < count; ++r) {
+                ActivationFunction::applyInPlace(activation, output.rowData(first + r), outputSize);
+            }
+        }
+    });
+}
+
+WeightPrecision QuantizedLayer::getPrecision() const {
+    return precision;
+}
+
+int QuantizedLayer::getInputSize() const {
+    return inputSize;
+}
+
+int QuantizedLayer::getOutputSize() const {
+    return outputSize;
+}
+
+std::size_t QuantizedLayer::getWeightBytes() const {
+    return int8Weights.size() * sizeof(std::int8_t) + halfWeights.size() * sizeof(std::uint16_t)
+        + (scales.size() + biases.size()) * sizeof(float);
+}
+
+QuantizedNetwork::QuantizedNetwork(const NeuralNetwork& network, WeightPrecision precision) {
+    for (const Layer& layer : network.layers) {
+        layers.emplace_back(layer, precision);
+    }
+}
+
+QuantizedNetwork QuantizedNetwork::calibrate(
+    NeuralNetwork& network, WeightPrecision precision, const Matrix& samples, CalibrationReport& report
+) {
+    QuantizedNetwork quantized(network, precision);
+    const Matrix expected = network.predict(samples);
+    const Matrix actual = quantized.predict(samples);
+
+    report = {};
+    double totalError = 0.;
+    int agreeing = 0;
+    for (int i = 0; i < expected.getRows(); ++i) {
+        const float* expectedRow = expected.rowData(i);
+        const float* actualRow = actual.rowData(i);
+        for (int j = 0; j < expected.getCols(); ++j) {
+            const float error = std::fabs(expectedRow[j] - actualRow[j]);
+            report.maxAbsoluteError = std::max(report.maxAbsoluteError, error);
+            totalError += error;
+        }
+        const int cols = expected.getCols();
+        agreeing += std::max_element(expectedRow, expectedRow + cols) - expectedRow
+            == std::max_element(actualRow, actualRow + cols) - actualRow;
+    }
+    if (expected.getRows() > 0) {
+        report.meanAbsoluteError = static_cast<float>(totalError / (static_cast<double>(expected.getRows()) * expected.getCols()));
+        report.argmaxAgreement = static_cast<float>(agreeing) / static_cast<float>(expected.getRows());
+    }
+    report.fp32Bytes = network.getParameters().size_bytes();
+    report.quantizedBytes = quantized.getWeightBytes();
+    return quantized;
+}
+
+Matrix QuantizedNetwork::predict(const Matrix& input) {
+    Matrix output;
+    predict(input, output);
+    return output;
+}
+
+void QuantizedNetwork::predict(const Matrix& input, Matrix& output) {
+    const Matrix* current = &input;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        Matrix& next = i + 1 == layers.size() ? output : activations[i % 2];
+        layers[i].forwardInto(*current, next);
+        current = &next;
+    }
+}
+
+WeightPrecision QuantizedNetwork::getPrecision() const {
+    return layers.front().getPrecision();
+}
+
+std::size_t QuantizedNetwork::getWeightBytes() const {
+    std::size_t bytes = 0;
+    for (const QuantizedLayer& layer : layers) {
+        bytes += layer.getWeightBytes();
+    }
+    return bytes;
+}
+
+} // nnn
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include "random.hpp"
+#include <random>
+#include "thread_pool.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NNN_RANDOM_X86
+#endif
+
+#define NNN_ALWAYS_INLINE inline __attribute__((always_inline))
+
+namespace nnn {
+
+namespace {
+
+constexpr std::uint32_t PHILOX_M0 = 0xD2511F53u;
+constexpr std::uint32_t PHILOX_M1 = 0xCD9E8D57u;
+constexpr std::uint32_t PHILOX_W0 = 0x9E3779B9u;
+constexpr std::uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+// Philox blocks are generated LANES at a time, one per SIMD lane: batch `b` holds blocks LANES * b onwards
+// and is laid out word-major (word `w` of block `l` at index `w * LANES + l`), which is the order in which
+// both scalar draws and bulk fills consume it.
+constexpr int LANES = 16;
+constexpr int BATCH = 4 * LANES;
+
+using BatchKernel = void (*)(std::uint64_t key, std::uint64_t stream, std::uint64_t batch, std::uint32_t* out);
+
+// Philox4x32-10 of one 128-bit counter.
+NNN_ALWAYS_INLINE void philoxBlock(std::uint64_t key, std::uint64_t stream, std::uint64_t block, std::uint32_t* out) {
+    std::uint32_t c0 = static_cast<std::uint32_t>(block);
+    std::uint32_t c1 = static_cast<std::uint32_t>(block >> 32);
+    std::uint32_t c2 = static_cast<std::uint32_t>(stream);
+    std::uint32_t c3 = static_cast<std::uint32_t>(stream >> 32);
+    std::uint32_t k0 = static_cast<std::uint32_t>(key);
+    std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const std::uint64_t p0 = static_cast<std::uint64_t>(PHILOX_M0) * c0;
+        const std::uint64_t p1 = static_cast<std::uint64_t>(PHILOX_M1) * c2;
+        c0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        c2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<std::uint32_t>(p1);
+        c3 = static_cast<std::uint32_t>(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[LANES] = c1;
+    out[2 * LANES] = c2;
+    out[3 * LANES] = c3;
+}
+
+void philoxBatchScalar(std::uint64_t key, std::uint64_t stream, std::uint64_t batch, std::uint32_t* out) {
+    for (int l = 0; l < LANES; ++l) {
+        philoxBlock(key, stream, batch * LANES + l, out + l);
+    }
+}
+
+#ifdef NNN_RANDOM_X86
+// The 32 x 32 -> 64 bit products are formed with `mul_epu32` on the even lanes and on the odd lanes shifted
+// down, then the high and low halves are blended back into 32-bit lanes.
+__attribute__((target("avx2")))
+void philoxBatchAvx2(std::uint64_t key, std::uint64_t stream, std::uint64_t batch, std::uint32_t* out) {
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+    for (int half = 0; half < LANES; half += 8) {
+        const std::uint64_t first = batch * LANES + half;
+        __m256i c0 = _mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(first))), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+        );
+        // `first` is a multiple of 8, so the low word never carries within a group.
+        __m256i c1 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(first >> 32)));
+        __m256i c2 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream)));
+        __m256i c3 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream >> 32)));
+        std::uint32_t k0 = static_cast<std::uint32_t>(key);
+        std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+        for (int round = 0; round < 10; ++round) {
+            const __m256i p0Even = _mm256_mul_epu32(c0, m0);
+            const __m256i p0Odd = _mm256_mul_epu32(_mm256_srli_epi64(c0, 32), m0);
+            const __m256i p1Even = _mm256_mul_epu32(c2, m1);
+            const __m256i p1Odd = _mm256_mul_epu32(_mm256_srli_epi64(c2, 32), m1);
+            const __m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(p0Even, 32), p0Odd, 0xAA);
+            const __m256i lo0 = _mm256_blend_epi32(p0Even, _mm256_slli_epi64(p0Odd, 32), 0xAA);
+            const __m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(p1Even, 32), p1Odd, 0xAA);
+            const __m256i lo1 = _mm256_blend_epi32(p1Even, _mm256_slli_epi64(p1Odd, 32), 0xAA);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+            c1 = lo1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + half), c0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + LANES + half), c1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * LANES + half), c2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 3 * LANES + half), c3);
+    }
+}
+
+// GCC 12's avx512fintrin.h trips -Wuninitialized on its own `__Y` placeholders; the warning is a false positive.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+__attribute__((target("avx512f")))
+void philoxBatchAvx512(std::uint64_t key, std::uint64_t stream, std::uint64_t batch, std::uint32_t* out) {
+    const __m512i m0 = _mm512_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m512i m1 = _mm512_set1_epi32(static_cast<int>(PHILOX_M1));
+    const std::uint64_t first = batch * LANES;
+    __m512i c0 = _mm512_add_epi32(
+        _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(first))),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+    );
+    // `first` is a multiple of 16, so the low word never carries within the batch.
+    __m512i c1 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(first >> 32)));
+    __m512i c2 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream)));
+    __m512i c3 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream >> 32)));
+    std::uint32_t k0 = static_cast<std::uint32_t>(key);
+    std::uint32_t k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const __m512i p0Even = _mm512_mul_epu32(c0, m0);
+        const __m512i p0Odd = _mm512_mul_epu32(_mm512_srli_epi64(c0, 32), m0);
+        const __m512i p1Even = _mm512_mul_epu32(c2, m1);
+        const __m512i p1Odd = _mm512_mul_epu32(_mm512_srli_epi64(c2, 32), m1);
+        const __m512i hi0 = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(p0Even, 32), p0Odd);
+        const __m512i lo0 = _mm512_mask_blend_epi32(0xAAAA, p0Even, _mm512_slli_epi64(p0Odd, 32));
+        const __m512i hi1 = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(p1Even, 32), p1Odd);
+        const __m512i lo1 = _mm512_mask_blend_epi32(0xAAAA, p1Even, _mm512_slli_epi64(p1Odd, 32));
+        c0 = _mm512_xor_si512(_mm512_xor_si512(hi1, c1), _mm512_set1_epi32(static_cast<int>(k0)));
+        c2 = _mm512_xor_si512(_mm512_xor_si512(hi0, c3), _mm512_set1_epi32(static_cast<int>(k1)));
+        c1 = lo1;
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    _mm512_storeu_si512(out, c0);
+    _mm512_storeu_si512(out + LANES, c1);
+    _mm512_storeu_si512(out + 2 * LANES, c2);
+    _mm512_storeu_si512(out + 3 * LANES, c3);
+}
+#pragma GCC diagnostic pop
+#endif
+
+BatchKernel batchKernel() {
+#ifdef NNN_RANDOM_X86
+    static const BatchKernel selected =
+        __builtin_cpu_supports("avx512f") ? philoxBatchAvx512
+        : __builtin_cpu_supports("avx2") ? philoxBatchAvx2
+        : philoxBatchScalar;
+    return selected;
+#else
+    return philoxBatchScalar;
+#endif
+}
+
+// Top 24 bits scaled to [0, 1).
+NNN_ALWAYS_INLINE float toUnit(std::uint32_t bits) {
+    return static_cast<float>(static_cast<std::int32_t>(bits >> 8)) * 0x1p-24f;
+}
+
+// Fills `count` floats with low + (high - low) * uniform, from batches starting at `first`.
+void uniformBatches(
+    std::uint64_t key, std::uint64_t stream, std::uint64_t first, float* values, std::size_t count, float low, float high
+) {
+    const BatchKernel kernel = batchKernel();
+    const float scale = high - low;
+    alignas(64) std::uint32_t bits[BATCH];
+    for (std::size_t done = 0; done < count; done += BATCH) {
+        kernel(key, stream, first + done / BATCH, bits);
+        const std::size_t size = std::min<std::size_t>(BATCH, count - done);
+        for (std::size_t i = 0; i < size; ++i) {
+            values[done + i] = low + scale * toUnit(bits[i]);
+        }
+    }
+}
+
+// Fills `values` from batches starting at `first`, in parallel for large fills. Tasks start on batch
+// boundaries, so every value comes from the same batch whatever the split.
+void fillUniformBatches(std::uint64_t key, std::uint64_t stream, std::uint64_t first, std::span<float> values, float low, float high) {
+    const int batches = static_cast<int>((values.size() + BATCH - 1) / BATCH);
+    ThreadPool::parallelFor(batches, ThreadPool::ELEMENTWISE_GRAIN / BATCH, [&](int begin, int end) {
+        const std::size_t offset = static_cast<std::size_t>(begin) * BATCH;
+        const std::size_t count = std::min(values.size(), static_cast<std::size_t>(end) * BATCH) - offset;
+        uniformBatches(key, stream, first + begin, values.data() + offset, count, low, high);
+    });
+}
+
+// Turns pairs of uniforms in [0, 1) into pairs of standard normals in place.
+void boxMuller(float* values, std::size_t pairs, float mean, float stddev) {
+    constexpr float TWO_PI = 6.28318531f;
+    for (std::size_t i = 0; i < pairs; ++i) {
+        // 1 - u lies in (0, 1], keeping the logarithm finite.
+        const float radius = std::sqrt(-2.f * std::log(1.f - values[2 * i]));
+        const float angle = TWO_PI * values[2 * i + 1];
+        values[2 * i] = mean + stddev * radius * std::cos(angle);
+        values[2 * i + 1] = mean + stddev * radius * std::sin(angle);
+    }
+}
+
+struct GlobalState {
+    std::mutex mutex;
+    std::uint64_t seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    std::uint64_t nextStream = 0;
+};
+
+GlobalState& globalState() {
+    static GlobalState state;
+    return state;
+}
+
+} // namespace
+
+Random::Random(std::uint64_t seed, std::uint64_t stream) : key(seed), stream(stream) {}
+
+Random Random::split(std::uint64_t id) const {
+    // The child stream is a Philox output of (this stream, id) under a different counter space, so children
+    // of different parents or ids do not collide in practice.
+    std::uint32_t bits[4 * LANES];
+    philoxBlock(key, stream ^ 0x5851F42D4C957F2Dull, id, bits);
+    return Random(key, static_cast<std::uint64_t>(bits[0]) | static_cast<std::uint64_t>(bits[LANES]) << 32);
+}
+
+void Random::refill() {
+    batchKernel()(key, stream, counter++, buffer);
+    buffered = BUFFER_SIZE;
+}
+
+std::uint32_t Random::nextUint() {
+    if (buffered == 0) {
+        refill();
+    }
+    return buffer[BUFFER_SIZE - buffered--];
+}
+
+float Random::uniform() {
+    return toUnit(nextUint());
+}
+
+float Random::uniform(float low, float high) {
+    return low + (high - low) * uniform();
+}
+
+float Random::normal(float mean, float stddev) {
+    float pair[2] = { uniform(), uniform() };
+    boxMuller(pair, 1, mean, stddev);
+    return pair[0];
+}
+
+void Random::fillUniform(std::span<float> values, float low, float high) {
+    // Bulk output always starts on a fresh batch; words left in the scalar buffer are dropped.
+    buffered = 0;
+    fillUniformBatches(key, stream, counter, values, low, high);
+    counter += (values.size() + BATCH - 1) / BATCH;
+}
+
+void Random::fillNormal(std::span<float> values, float mean, float stddev) {
+    fillUniform(values, 0.f, 1.f);
+    const std::size_t pairs = values.size() / 2;
+    ThreadPool::parallelFor(static_cast<int>(pairs), ThreadPool::ELEMENTWISE_GRAIN / 2, [&](int begin, int end) {
+        boxMuller(values.data() + 2 * static_cast<std::size_t>(begin), end - begin, mean, stddev);
+    });
+    if (values.size() % 2 != 0) {
+        values.back() = normal(mean, stddev);
+    }
+}
+
+void Random::setGlobalSeed(std::uint64_t seed) {
+    GlobalState& state = globalState();
+    std::lock_guard lock(state.mutex);
+    state.seed = seed;
+    state.nextStream = 0;
+}
+
+Random Random::global() {
+    GlobalState& state = globalState();
+    std::lock_guard lock(state.mutex);
+    return Random(state.seed).split(state.nextStream++);
+}
+
+} // nnn
+
+#undef NNN_ALWAYS_INLINE
+#undef NNN_RANDOM_X86
@@ -0,0 +1,275 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "thread_pool.hpp"
+#include <vector>
+
+namespace nnn {
+
+namespace {
+
+// Chunk indices [begin, end) still owned by one thread, packed into one word so that the owner and thieves
+// can update it with a single compare-and-swap.
+struct alignas(64) ChunkRange {
+    std::atomic<std::uint64_t> bounds{ 0 };
+
+    static std::uint64_t pack(std::uint32_t begin, std::uint32_t end) {
+        return static_cast<std::uint64_t>(end) << 32 | begin;
+    }
+};
+
+// One parallelFor call. Lives on the caller's stack; workers only touch it between joining and leaving.
+// Chunks start out split evenly between the threads. Each thread takes chunks from the front of its own
+// range and, once that is empty, steals the back half of another thread's range, so threads that wake
+// late or get slow chunks do not hold up the rest.
+struct Job {
+    void (*task)(void* context, int begin, int end);
+    void* context;
+    int count;
+    int chunkSize;
+    ChunkRange* ranges;
+    int threads;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void distribute(int chunkCount) {
+        for (int t = 0; t < threads; ++t) {
+            const auto begin = static_cast<std::uint32_t>(static_cast<long long>(chunkCount) * t / threads);
+            const auto end = static_cast<std::uint32_t>(static_cast<long long>(chunkCount) * (t + 1) / threads);
+            ranges[t].bounds.store(ChunkRange::pack(begin, end), std::memory_order_relaxed);
+        }
+    }
+
+    void work(int self) {
+        while (true) {
+            int chunk = popFront(ranges[self]);
+            for (int offset = 1; chunk < 0 && offset < threads; ++offset) {
+                chunk = steal(ranges[(self + offset) % threads], ranges[self]);
+            }
+            if (chunk < 0) {
+                return;
+            }
+            run(chunk);
+        }
+    }
+
+private:
+    static int popFront(ChunkRange& range) {
+        std::uint64_t bounds = range.bounds.load(std::memory_order_acquire);
+        while (true) {
+            const auto begin = static_cast<std::uint32_t>(bounds);
+            const auto end = static_cast<std::uint32_t>(bounds >> 32);
+            if (begin >= end) {
+                return -1;
+            }
+            if (range.bounds.compare_exchange_weak(bounds, ChunkRange::pack(begin + 1, end), std::memory_order_acq_rel)) {
+                return static_cast<int>(begin);
+            }
+        }
+    }
+
+    // Moves the back half of `victim` into the (empty) `own` range and returns its first chunk.
+    static int steal(ChunkRange& victim, ChunkRange& own) {
+        std::uint64_t bounds = victim.bounds.load(std::memory_order_acquire);
+        while (true) {
+            const auto begin = static_cast<std::uint32_t>(bounds);
+            const auto end = static_cast<std::uint32_t>(bounds >> 32);
+            if (begin >= end) {
+                return -1;
+            }
+            const std::uint32_t split = end - (end - begin + 1) / 2;
+            if (victim.bounds.compare_exchange_weak(bounds, ChunkRange::pack(begin, split), std::memory_order_acq_rel)) {
+                own.bounds.store(ChunkRange::pack(split + 1, end), std::memory_order_release);
+                return static_cast<int>(split);
+            }
+        }
+    }
+
+    void run(int chunk) {
+        const int begin = chunk * chunkSize;
+        try {
+            task(context, begin, std::min(count, begin + chunkSize));
+        } catch (...) {
+            std::lock_guard lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+};
+
+// True on pool workers and on a caller while it runs a job; nested parallelFor calls then run inline.
+thread_local bool insideParallelFor = false;
+// Index of the current thread within the pool: workers are 1.., every other thread is 0.
+thread_local int threadSlot = 0;
+
+class Workers {
+public:
+    int threadCount() {
+        // Read without the submit lock, which a running job holds.
+        const int count = configuredCount.load(std::memory_order_acquire);
+        if (count != 0) {
+            return count;
+        }
+        std::lock_guard lock(submitMutex);
+        ensureStarted();
+        return configuredCount.load(std::memory_order_relaxed);
+    }
+
+    void resize(int count) {
+        std::lock_guard lock(submitMutex);
+        stop();
+        start(count > 0 ? count : hardwareThreads());
+    }
+
+    bool run(Job& job) {
+        std::unique_lock submit(submitMutex, std::try_to_lock);
+        if (!submit.owns_lock()) {
+            return false;
+        }
+        ensureStarted();
+        if (threads.empty()) {
+            return false;
+        }
+        job.ranges = ranges.get();
+        job.threads = static_cast<int>(threads.size()) + 1;
+        job.distribute((job.count + job.chunkSize - 1) / job.chunkSize);
+
+        {
+            std::lock_guard lock(mutex);
+            current = &job;
+            ++generation;
+        }
+        wake.notify_all();
+
+        insideParallelFor = true;
+        job.work(0);
+        insideParallelFor = false;
+
+        // Late workers must not join once every chunk is claimed; wait for those still running one.
+        std::unique_lock lock(mutex);
+        current = nullptr;
+        idle.wait(lock, [this] { return active == 0; });
+        return true;
+    }
+
+private:
+    static int hardwareThreads() {
+        return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    void ensureStarted() {
+        if (!started) {
+            start(hardwareThreads());
+        }
+    }
+
+    void start(int count) {
+        started = true;
+        stopping = false;
+        ranges = std::make_unique<ChunkRange[]>(count);
+        for (int i = 1; i < count; ++i) {
+            threads.emplace_back([this, i] { workerLoop(i); });
+        }
+        configuredCount.store(count, std::memory_order_release);
+    }
+
+    void stop() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+    void workerLoop(int slot) {
+        insideParallelFor = true;
+        threadSlot = slot;
+        std::uint64_t seen = 0;
+        std::unique_lock lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || (current != nullptr && generation != seen); });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            Job& job = *current;
+            ++active;
+            lock.unlock();
+
+            job.work(threadSlot);
+
+            lock.lock();
+            if (--active == 0) {
+                idle.notify_one();
+            }
+        }
+    }
+
+    // Serializes callers and resizing; a caller that cannot take it runs its work inline.
+    std::mutex submitMutex;
+    std::vector<std::thread> threads;
+    std::unique_ptr<ChunkRange[]> ranges;
+    bool started = false;
+    std::atomic<int> configuredCount{ 0 };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Job* current = nullptr;
+    std::uint64_t generation = 0;
+    int active = 0;
+    bool stopping = false;
+};
+
+Workers& workers() {
+    // Never destroyed: workers may still be parked in `wake` when static destructors run.
+    static auto* instance = new Workers();
+    return *instance;
+}
+
+} // namespace
+
+void ThreadPool::setThreadCount(int count) {
+    workers().resize(count);
+}
+
+int ThreadPool::getThreadCount() {
+    return workers().threadCount();
+}
+
+int ThreadPool::threadIndex() {
+    return threadSlot;
+}
+
+void ThreadPool::run(int count, int grain, Task task, void* context) {
+    Job job;
+    job.task = task;
+    job.context = context;
+    job.count = count;
+
+    const int threads = insideParallelFor ? 1 : getThreadCount();
+    if (threads > 1) {
+        // A few chunks per thread, so uneven chunks still balance out.
+        const int tasks = 4 * threads;
+        job.chunkSize = std::max(std::max(grain, 1), (count + tasks - 1) / tasks);
+        if (job.chunkSize < count && workers().run(job)) {
+            if (job.error) {
+                std::rethrow_exception(job.error);
+            }
+            return;
+        }
+    }
+
+    task(context, 0, count);
+}
+
+} // nnn
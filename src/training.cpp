@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include "training.hpp"
+#include <utility>
+
+namespace nnn {
+
+LogSink& LogSink::standardOutput() {
+    static BufferedLogSink sink(std::cout);
+    return sink;
+}
+
+BufferedLogSink::BufferedLogSink(std::ostream& stream) : stream(stream), worker([this] { run(); }) {}
+
+BufferedLogSink::~BufferedLogSink() {
+    {
+        const std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    pendingChanged.notify_all();
+    worker.join();
+}
+
+void BufferedLogSink::write(std::string line) {
+    {
+        const std::lock_guard lock(mutex);
+        pending.push_back(std::move(line));
+    }
+    pendingChanged.notify_all();
+}
+
+void BufferedLogSink::flush() {
+    std::unique_lock lock(mutex);
+    pendingChanged.wait(lock, [&] { return pending.empty() && !writing; });
+}
+
+void BufferedLogSink::run() {
+    std::vector<std::string> batch;
+    std::unique_lock lock(mutex);
+    while (true) {
+        pendingChanged.wait(lock, [&] { return !pending.empty() || stopping; });
+        if (pending.empty()) {
+            return;
+        }
+
+        // Lines are written in batches, outside the lock, so that writers only ever wait for a swap.
+        batch.swap(pending);
+        writing = true;
+        lock.unlock();
+        for (const std::string& line : batch) {
+            stream << line << '\n';
+        }
+        stream.flush();
+        batch.clear();
+        lock.lock();
+        writing = false;
+        pendingChanged.notify_all();
+    }
+}
+
+TrainingMonitor::TrainingMonitor(const TrainingOptions& options, const char* lossLabel)
+    : options(options), lossLabel(lossLabel), log(options.log != nullptr ? *options.log : LogSink::standardOutput()),
+      start(Clock::now()), epochStart(start), bestLoss(std::numeric_limits<float>::infinity()) {
+    if (options.epochs < 0 || options.patience < 0 || options.logInterval < 0 || options.timeBudgetSeconds < 0.) {
+        throw std::runtime_error("TrainingMonitor::TrainingMonitor: options must not be negative");
+    }
+    result.losses.reserve(options.epochs);
+    stopped = options.epochs == 0;
+}
+
+bool TrainingMonitor::shouldContinue() const {
+    return !stopped;
+}
+
+void TrainingMonitor::endEpoch(float loss) {
+    const Clock::time_point now = Clock::now();
+    const EpochMetrics metrics{
+        result.epochs,
+        loss,
+        std::chrono::duration<double>(now - epochStart).count(),
+        std::chrono::duration<double>(now - start).count(),
+    };
+    epochStart = now;
+    result.losses.push_back(loss);
+    ++result.epochs;
+
+    if (options.logInterval > 0 && metrics.epoch % options.logInterval == 0) {
+        // Only the formatting happens here; the sink does the I/O.
+        char line[96];
+        std::snprintf(line, sizeof(line), "Epoch: %d - %s: %g", metrics.epoch, lossLabel, static_cast<double>(loss));
+        log.write(line);
+    }
+
+    if (loss < bestLoss - options.minImprovement) {
+        bestLoss = loss;
+        epochsWithoutImprovement = 0;
+    } else {
+        ++epochsWithoutImprovement;
+    }
+
+    // The callback sees every epoch, including the one that meets a stopping rule.
+    const bool callbackContinues = !options.onEpoch || options.onEpoch(metrics);
+    if (!callbackContinues) {
+        result.stopReason = StopReason::Callback;
+    } else if (options.targetLoss >= 0.f && loss <= options.targetLoss) {
+        result.stopReason = StopReason::LossTarget;
+    } else if (options.patience > 0 && epochsWithoutImprovement >= options.patience) {
+        result.stopReason = StopReason::Plateau;
+    } else if (options.timeBudgetSeconds > 0. && metrics.elapsedSeconds >= options.timeBudgetSeconds) {
+        result.stopReason = StopReason::TimeBudget;
+    } else {
+        stopped = result.epochs >= options.epochs;
+        return;
+    }
+    stopped = true;
+}
+
+TrainingResult TrainingMonitor::finish() {
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    // Training's output must not trail behind it: the caller may go on writing to the same stream.
+    log.flush();
+    return std::move(result);
+}
+
+} // nnn
@@ -1,4 +1,8 @@
 #define TOASTY_IMPLEMENTATION
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
 extern "C" {
 #include "toasty.h"
 }
@@ -23,6 +27,138 @@ TEST(test_SigmoidShouldCalculateProperResults) {
     TEST_ASSERT_EQUAL_FLOAT(0.f, output(0, 0));
 }
 
+TEST(test_ActivationsShouldCalculateProperResults) {
+    const Matrix input(1, 3, { -2.f, 0.f, 3.f });
+
+    const Matrix tanh = ActivationFunction::tanh(input);
+    const Matrix relu = ActivationFunction::relu(input);
+    const Matrix leakyRelu = ActivationFunction::leakyRelu(input);
+    const Matrix gelu = ActivationFunction::gelu(input);
+
+    for (int j = 0; j < 3; ++j) {
+        const float x = input(0, j);
+        TEST_ASSERT_EQUAL_FLOAT(std::tanh(x), tanh(0, j));
+        TEST_ASSERT_EQUAL_FLOAT(x > 0.f ? x : 0.f, relu(0, j));
+        TEST_ASSERT_EQUAL_FLOAT(x > 0.f ? x : x * ActivationFunction::LEAKY_RELU_SLOPE, leakyRelu(0, j));
+        TEST_ASSERT_EQUAL_FLOAT(0.5f * x * (1.f + std::erf(x / std::sqrt(2.f))), gelu(0, j));
+    }
+}
+
+TEST(test_SoftmaxShouldNormalizeEachRow) {
+    const Matrix input(2, 3, { 1.f, 2.f, 3.f, 1000.f, 1000.f, 1000.f });
+
+    const Matrix output = ActivationFunction::softmax(input);
+
+    const float total = std::exp(1.f) + std::exp(2.f) + std::exp(3.f);
+    TEST_ASSERT_EQUAL_FLOAT(std::exp(1.f) / total, output(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(std::exp(3.f) / total, output(0, 2));
+    for (int j = 0; j < 3; ++j) {
+        TEST_ASSERT_EQUAL_FLOAT(1.f / 3.f, output(1, j));
+    }
+}
+
+TEST(test_ApproximateAccuracyModesShouldStayWithinDocumentedErrors) {
+    Matrix input(1, 801);
+    for (int j = 0; j < input.getCols(); ++j) {
+        input(0, j) = -20.f + 0.05f * static_cast<float>(j);
+    }
+
+    const Activation activations[] = { Activation::Sigmoid, Activation::Tanh, Activation::GELU, Activation::Softmax };
+    const float fastErrors[] = { 1.2e-7f, 1.2e-7f, 5e-7f, 3e-7f };
+    const float ultraFastErrors[] = { 2e-5f, 4e-5f, 5e-4f, 1.5e-4f };
+
+    for (int a = 0; a < 4; ++a) {
+        ActivationFunction::setAccuracy(ActivationAccuracy::Exact);
+        const Matrix exact = ActivationFunction::apply(activations[a], input);
+        ActivationFunction::setAccuracy(ActivationAccuracy::Fast);
+        const Matrix fast = ActivationFunction::apply(activations[a], input);
+        ActivationFunction::setAccuracy(ActivationAccuracy::UltraFast);
+        const Matrix ultraFast = ActivationFunction::apply(activations[a], input);
+        ActivationFunction::setAccuracy(ActivationAccuracy::Exact);
+
+        for (int j = 0; j < input.getCols(); ++j) {
+            TEST_ASSERT_TRUE(std::fabs(exact(0, j) - fast(0, j)) <= fastErrors[a]);
+            TEST_ASSERT_TRUE(std::fabs(exact(0, j) - ultraFast(0, j)) <= ultraFastErrors[a]);
+        }
+    }
+}
+
+TEST(test_ActivationsShouldCoverEveryElementOfPaddedAndBlockedMatrices) {
+    // A padded wide matrix, and a dense one spanning several processing blocks.
+    for (const auto& [rows, cols] : { std::pair{ 3, 70 }, std::pair{ 300, 30 } }) {
+        Matrix x(rows, cols);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                x(i, j) = static_cast<float>((i + j) % 7) - 3.f;
+            }
+        }
+
+        const Matrix activated = ActivationFunction::relu(x);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                TEST_ASSERT_EQUAL_FLOAT(std::max(x(i, j), 0.f), activated(i, j));
+            }
+        }
+    }
+}
+
+TEST(test_ActivationsShouldSkipTheGapsOfStridedViews) {
+    float buffer[6] = { -1.f, 2.f, -7.f, 3.f, -4.f, -7.f };
+    Matrix view = Matrix::view(buffer, 2, 2, 3);
+
+    const Matrix activated = ActivationFunction::relu(view);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, activated(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(2.f, activated(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(3.f, activated(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.f, activated(1, 1));
+
+    ActivationFunction::applyInto(Activation::ReLU, view, view);
+    const float expected[6] = { 0.f, 2.f, -7.f, 3.f, 0.f, -7.f };
+    for (int i = 0; i < 6; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], buffer[i]);
+    }
+}
+
+TEST(test_BackwardShouldMatchFiniteDifferences) {
+    const Activation activations[] = {
+        Activation::Sigmoid, Activation::Tanh, Activation::ReLU, Activation::LeakyReLU, Activation::GELU,
+        Activation::Softmax,
+    };
+    const float inputs[] = { -1.7f, -0.4f, 0.3f, 1.2f };
+    // Weights of the loss sum(weights * outputs), so the output gradients are these weights.
+    const float weights[] = { 0.5f, -1.f, 2.f, 0.25f };
+    const auto loss = [&](Activation activation, const float* x) {
+        float values[4];
+        std::copy_n(x, 4, values);
+        ActivationFunction::applyInPlace(activation, values, 4);
+        double sum = 0.0;
+        for (int i = 0; i < 4; ++i) {
+            sum += weights[i] * values[i];
+        }
+        return sum;
+    };
+
+    for (const Activation activation : activations) {
+        float outputs[4];
+        float gradients[4];
+        std::copy_n(inputs, 4, outputs);
+        std::copy_n(weights, 4, gradients);
+        ActivationFunction::applyInPlace(activation, outputs, 4);
+        ActivationFunction::backwardInPlace(activation, inputs, outputs, gradients, 4);
+
+        for (int i = 0; i < 4; ++i) {
+            constexpr float h = 1e-3f;
+            float shifted[4];
+            std::copy_n(inputs, 4, shifted);
+            shifted[i] += h;
+            const double up = loss(activation, shifted);
+            shifted[i] -= 2.f * h;
+            const double down = loss(activation, shifted);
+            TEST_ASSERT_TRUE(std::fabs((up - down) / (2.f * h) - gradients[i]) < 1e-3);
+        }
+    }
+}
+
 int main() {
     return RunTests();
 }
@@ -0,0 +1,87 @@
+#define TOASTY_IMPLEMENTATION
+#include "allocator.hpp"
+#include <cstdint>
+#include "matrix.hpp"
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static bool isAligned(const float* pointer) {
+    return reinterpret_cast<std::uintptr_t>(pointer) % MATRIX_ALIGNMENT == 0;
+}
+
+TEST(test_PoolShouldReuseFreedBlocks) {
+    PoolAllocator pool;
+    float* first = pool.allocate(100);
+    TEST_ASSERT_TRUE(isAligned(first));
+    pool.deallocate(first, 100);
+
+    // 120 floats falls into the same size class as 100.
+    float* second = pool.allocate(120);
+    TEST_ASSERT_TRUE(first == second);
+    pool.deallocate(second, 120);
+
+    const AllocationStats stats = pool.stats();
+    TEST_ASSERT_EQUAL_UINT64(2, stats.allocations);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.deallocations);
+    TEST_ASSERT_EQUAL_UINT64(220 * sizeof(float), stats.bytesAllocated);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.poolHits);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.systemAllocations);
+}
+
+TEST(test_MatricesShouldTakeStorageFromTheDefaultAllocator) {
+    PoolAllocator pool;
+    MatrixAllocator::setDefault(&pool);
+    {
+        Matrix a(8, 8);
+        Matrix b = a;
+        TEST_ASSERT_TRUE(isAligned(a.data()));
+        TEST_ASSERT_TRUE(isAligned(b.data()));
+    }
+    {
+        Matrix c(8, 8);
+    }
+    MatrixAllocator::setDefault(nullptr);
+
+    const AllocationStats stats = pool.stats();
+    TEST_ASSERT_EQUAL_UINT64(3, stats.allocations);
+    TEST_ASSERT_EQUAL_UINT64(3, stats.deallocations);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.poolHits);
+    TEST_ASSERT_TRUE(&MatrixAllocator::getDefault() == &MatrixAllocator::pool());
+}
+
+TEST(test_MatrixShouldReturnStorageToTheAllocatorItCameFrom) {
+    PoolAllocator pool;
+    MatrixAllocator::setDefault(&pool);
+    Matrix a(4, 4);
+    MatrixAllocator::setDefault(&MatrixAllocator::system());
+    a = Matrix(2, 2);
+    MatrixAllocator::setDefault(nullptr);
+
+    TEST_ASSERT_EQUAL_UINT64(1, pool.stats().deallocations);
+}
+
+TEST(test_ArenaScopeShouldServeMatricesCreatedInside) {
+    AllocationStats stats;
+    {
+        ArenaScope arena(4096);
+        Matrix a(4, 4);
+        Matrix b(4, 4);
+        Matrix c = a + b;
+        TEST_ASSERT_TRUE(&MatrixAllocator::current() == &arena);
+        TEST_ASSERT_TRUE(isAligned(a.data()));
+        TEST_ASSERT_TRUE(isAligned(c.data()));
+        stats = arena.stats();
+    }
+    TEST_ASSERT_EQUAL_UINT64(3, stats.allocations);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.systemAllocations);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.poolHits);
+    TEST_ASSERT_TRUE(&MatrixAllocator::current() == &MatrixAllocator::getDefault());
+}
+
+int main() {
+    return RunTests();
+}
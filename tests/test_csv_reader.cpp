@@ -0,0 +1,109 @@
+#define TOASTY_IMPLEMENTATION
+#include "csv_reader.hpp"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "thread_pool.hpp"
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static std::string writeFile(const char* name, const std::string& contents) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream << contents;
+    return path;
+}
+
+static std::string readError(const std::string& path) {
+    try {
+        (void) CsvReader::read(path);
+    } catch (std::runtime_error& e) {
+        return e.what();
+    }
+    return {};
+}
+
+TEST(test_ReadShouldParseFieldsIntoRows) {
+    const std::string path = writeFile("nnn_test_read.csv", "a,b,c\r\n1, -2.5 ,+3\r\n\r\n4e2,0.125,-0\r\n");
+    const Matrix matrix = CsvReader::read(path, { ',', true });
+
+    TEST_ASSERT_EQUAL(2, matrix.getRows());
+    TEST_ASSERT_EQUAL(3, matrix.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(1.f, matrix(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, matrix(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(3.f, matrix(0, 2));
+    TEST_ASSERT_EQUAL_FLOAT(400.f, matrix(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.125f, matrix(1, 1));
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_ReadIntoShouldSplitInputsAndTargets) {
+    const std::string path = writeFile("nnn_test_split.csv", "0;1;1\n1;1;0");
+    Matrix inputs(2, 2);
+    Matrix targets(2, 1);
+    CsvReader::readInto(inputs, targets, path, { ';' });
+
+    TEST_ASSERT_EQUAL_FLOAT(0.f, inputs(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(1.f, inputs(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(1.f, inputs(1, 1));
+    TEST_ASSERT_EQUAL_FLOAT(1.f, targets(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.f, targets(1, 0));
+
+    Matrix wrongShape(3, 3);
+    try {
+        CsvReader::readInto(wrongShape, path, { ';' });
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_ReadShouldReportFirstMalformedLine) {
+    std::string path = writeFile("nnn_test_short.csv", "1,2\n3\n");
+    TEST_ASSERT_TRUE(readError(path).find("line 2, column 2") != std::string::npos);
+
+    path = writeFile("nnn_test_invalid.csv", "1,2\n\n3,x4\n");
+    TEST_ASSERT_TRUE(readError(path).find("line 3, column 2: invalid number `x4`") != std::string::npos);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove((std::filesystem::temp_directory_path() / "nnn_test_short.csv").string());
+}
+
+TEST(test_ParallelReadShouldMatchLineOrder) {
+    ThreadPool::setThreadCount(4);
+
+    // Large enough to be split into several chunks.
+    const int rows = 20000;
+    std::string contents;
+    for (int i = 0; i < rows; ++i) {
+        contents += std::to_string(i) + "," + std::to_string(i * 0.5f) + "\n";
+    }
+    std::string path = writeFile("nnn_test_large.csv", contents);
+    const Matrix matrix = CsvReader::read(path);
+    TEST_ASSERT_EQUAL(rows, matrix.getRows());
+    for (int i = 0; i < rows; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(i), matrix(i, 0));
+        TEST_ASSERT_EQUAL_FLOAT(i * 0.5f, matrix(i, 1));
+    }
+
+    // Errors late in the file are reported from their own chunk with the right line.
+    contents.replace(contents.find("\n17000,") + 1, 5, "bad!!");
+    contents.replace(contents.find("\n19000,") + 1, 5, "bad!!");
+    path = writeFile("nnn_test_large.csv", contents);
+    TEST_ASSERT_TRUE(readError(path).find("line 17001, column 1") != std::string::npos);
+
+    std::filesystem::remove(path);
+    ThreadPool::setThreadCount(0);
+}
+
+int main() {
+    return RunTests();
+}
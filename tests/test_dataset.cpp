@@ -0,0 +1,142 @@
+#define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "dataset.hpp"
+#include <filesystem>
+#include <fstream>
+#include "neural_network.hpp"
+#include "random.hpp"
+#include <stdexcept>
+#include <string>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static std::string temporaryPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static Matrix sequence(int rows, int cols, float offset) {
+    Matrix matrix(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            matrix(i, j) = offset + static_cast<float>(i * cols + j);
+        }
+    }
+    return matrix;
+}
+
+TEST(test_SavedDatasetShouldMapBackAsViews) {
+    const std::string path = temporaryPath("nnn_test_dataset.bin");
+    const Matrix inputs = sequence(10, 70, 0.f);
+    const Matrix targets = sequence(10, 3, 1000.f);
+    Dataset::save(path, inputs, targets);
+
+    const Dataset dataset(path);
+    TEST_ASSERT_EQUAL(10, dataset.getRows());
+    TEST_ASSERT_EQUAL(70, dataset.getInputSize());
+    TEST_ASSERT_EQUAL(3, dataset.getOutputSize());
+
+    const Matrix rows = dataset.inputs(2, 5);
+    TEST_ASSERT_TRUE(rows.isView());
+    TEST_ASSERT_EQUAL(3, rows.getRows());
+    TEST_ASSERT_EQUAL(80, rows.getStride());
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(rows.data()) % 64);
+    TEST_ASSERT_EQUAL_FLOAT(inputs(4, 69), rows(2, 69));
+    TEST_ASSERT_EQUAL_FLOAT(targets(9, 2), dataset.targets(0, 10)(9, 2));
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_BatchLoaderShouldCoverEveryRowOncePerEpoch) {
+    const std::string path = temporaryPath("nnn_test_batches.bin");
+    Dataset::save(path, sequence(10, 2, 0.f), sequence(10, 1, 0.f));
+    const Dataset dataset(path);
+
+    BatchLoader loader(dataset, 4);
+    Matrix inputs;
+    Matrix targets;
+    for (int epoch = 0; epoch < 2; ++epoch) {
+        int batches = 0;
+        int rows = 0;
+        while (loader.next(inputs, targets)) {
+            TEST_ASSERT_TRUE(inputs.isView());
+            TEST_ASSERT_EQUAL_FLOAT(static_cast<float>(rows), targets(0, 0));
+            rows += inputs.getRows();
+            ++batches;
+        }
+        TEST_ASSERT_EQUAL(3, batches);
+        TEST_ASSERT_EQUAL(10, rows);
+    }
+    // The first batch stays intact: the loader never writes through the previous views.
+    TEST_ASSERT_EQUAL_FLOAT(0.f, dataset.targets(0, 1)(0, 0));
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_OpeningInvalidDatasetShouldFail) {
+    const std::string path = temporaryPath("nnn_test_invalid.bin");
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "definitely not a dataset, but longer than one header of sixty-four bytes.....";
+    }
+
+    try {
+        const Dataset dataset(path);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+
+    // Headers of a valid file patched with a stride that `save` never writes, and with a row count whose byte
+    // size wraps around.
+    const auto opensPatched = [&](std::streamoff position, const auto& value) {
+        Dataset::save(path, sequence(4, 3, 0.f), sequence(4, 1, 0.f));
+        {
+            std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+            stream.seekp(position);
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        try {
+            const Dataset dataset(path);
+            return true;
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    };
+    TEST_ASSERT_FALSE(opensPatched(offsetof(DatasetHeader, inputStride), std::uint32_t(4)));
+    TEST_ASSERT_FALSE(opensPatched(offsetof(DatasetHeader, rows), (std::uint64_t(1) << 62) / 3 + 1));
+    TEST_ASSERT_TRUE(opensPatched(offsetof(DatasetHeader, rows), std::uint64_t(4)));
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_NetworkShouldTrainFromDataset) {
+    const std::string path = temporaryPath("nnn_test_xor.bin");
+    Dataset::save(
+        path,
+        Matrix(4, 2, { 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f }),
+        Matrix(4, 1, { 0.f, 1.f, 1.f, 0.f })
+    );
+    const Dataset dataset(path);
+
+    NeuralNetwork nn({ 2, 8, 1 }, { Activation::Tanh, Activation::Sigmoid });
+    nn.randomize(-1.f, 1.f, Random(7));
+    nn.train(dataset, 1000, 0.05f, OptimizerType::Adam, 2);
+
+    const Matrix predictions = nn.predict(dataset.inputs(0, 4));
+    const Matrix targets = dataset.targets(0, 4);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(std::fabs(predictions(i, 0) - targets(i, 0)) < 0.2f);
+    }
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,216 @@
+#define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+#include "gemm.hpp"
+
+using namespace nnn;
+
+static std::vector<float> makeValues(int count, int seed) {
+    std::vector<float> values(count);
+    for (int i = 0; i < count; ++i) {
+        values[i] = static_cast<float>((i * 7 + seed * 13) % 17) / 8.f - 1.f;
+    }
+    return values;
+}
+
+static std::vector<float> referenceMultiply(int m, int n, int k, const std::vector<float>& a, const std::vector<float>& b) {
+    std::vector<float> c(m * n, 0.f);
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+            double sum = 0.0;
+            for (int p = 0; p < k; ++p) {
+                sum += static_cast<double>(a[i * k + p]) * b[p * n + j];
+            }
+            c[i * n + j] = static_cast<float>(sum);
+        }
+    }
+    return c;
+}
+
+static bool multiplyMatchesReference(int m, int n, int k) {
+    const std::vector<float> a = makeValues(m * k, 1);
+    const std::vector<float> b = makeValues(k * n, 2);
+    const std::vector<float> expected = referenceMultiply(m, n, k, a, b);
+
+    std::vector<float> c(m * n, 123.f);
+    Gemm::multiply(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+
+    for (int i = 0; i < m * n; ++i) {
+        if (std::fabs(expected[i] - c[i]) > 1e-4f * static_cast<float>(k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stores a rows x cols row-major matrix as its transpose.
+static std::vector<float> transposedCopy(int rows, int cols, const std::vector<float>& values) {
+    std::vector<float> result(values.size());
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            result[j * rows + i] = values[i * cols + j];
+        }
+    }
+    return result;
+}
+
+static bool transposedMultiplyMatchesReference(int m, int n, int k, Transpose transposeA, Transpose transposeB) {
+    const std::vector<float> a = makeValues(m * k, 1);
+    const std::vector<float> b = makeValues(k * n, 2);
+    const std::vector<float> expected = referenceMultiply(m, n, k, a, b);
+    const std::vector<float> storedA = transposeA == Transpose::Yes ? transposedCopy(m, k, a) : a;
+    const std::vector<float> storedB = transposeB == Transpose::Yes ? transposedCopy(k, n, b) : b;
+
+    std::vector<float> c(m * n, 123.f);
+    Gemm::multiply(
+        transposeA, transposeB, m, n, k,
+        storedA.data(), transposeA == Transpose::Yes ? m : k,
+        storedB.data(), transposeB == Transpose::Yes ? k : n,
+        c.data(), n
+    );
+
+    for (int i = 0; i < m * n; ++i) {
+        if (std::fabs(expected[i] - c[i]) > 1e-4f * static_cast<float>(k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(test_MultiplyShouldMatchReferenceForEveryAvailableKernel) {
+    const GemmKernel kernels[] = { GemmKernel::Scalar, GemmKernel::Avx2, GemmKernel::Avx512 };
+
+    for (const GemmKernel kernel : kernels) {
+        if (!Gemm::setKernel(kernel)) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(Gemm::activeKernel() == kernel);
+
+        // Square, ragged edges, K spanning several cache blocks and N spanning several panels.
+        TEST_ASSERT_TRUE(multiplyMatchesReference(64, 64, 64));
+        TEST_ASSERT_TRUE(multiplyMatchesReference(37, 53, 71));
+        TEST_ASSERT_TRUE(multiplyMatchesReference(150, 41, 600));
+        TEST_ASSERT_TRUE(multiplyMatchesReference(7, 3100, 5));
+    }
+
+    TEST_ASSERT_TRUE(Gemm::setKernel(GemmKernel::Auto));
+}
+
+TEST(test_MultiplyShouldRespectLeadingDimensions) {
+    // 2x2 blocks embedded in wider 2x4 buffers.
+    const float a[] = { 1.f, 2.f, -1.f, -1.f, 3.f, 4.f, -1.f, -1.f };
+    const float b[] = { 5.f, 6.f, -1.f, -1.f, 7.f, 8.f, -1.f, -1.f };
+    float c[] = { 0.f, 0.f, 9.f, 9.f, 0.f, 0.f, 9.f, 9.f };
+
+    Gemm::multiply(2, 2, 2, a, 4, b, 4, c, 4);
+
+    TEST_ASSERT_EQUAL_FLOAT(19.f, c[0]);
+    TEST_ASSERT_EQUAL_FLOAT(22.f, c[1]);
+    TEST_ASSERT_EQUAL_FLOAT(43.f, c[4]);
+    TEST_ASSERT_EQUAL_FLOAT(50.f, c[5]);
+    TEST_ASSERT_EQUAL_FLOAT(9.f, c[2]);
+    TEST_ASSERT_EQUAL_FLOAT(9.f, c[7]);
+}
+
+TEST(test_MultiplyWithEmptyInnerDimensionShouldZeroOutput) {
+    float c[] = { 1.f, 2.f, 3.f, 4.f };
+
+    Gemm::multiply(2, 2, 0, nullptr, 0, nullptr, 2, c, 2);
+
+    for (const float value : c) {
+        TEST_ASSERT_EQUAL_FLOAT(0.f, value);
+    }
+}
+
+static void square(float* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        values[i] *= values[i];
+    }
+}
+
+TEST(test_EpilogueShouldAddBiasAndApplyActivationToEveryOutput) {
+    // Large enough to take the blocked path with several K blocks and ragged edge tiles.
+    const int m = 45, n = 70, k = 300;
+    const std::vector<float> a = makeValues(m * k, 3);
+    const std::vector<float> b = makeValues(k * n, 4);
+    const std::vector<float> bias = makeValues(n, 5);
+
+    std::vector<float> plain(m * n);
+    std::vector<float> fused(m * n);
+    Gemm::multiply(m, n, k, a.data(), k, b.data(), n, plain.data(), n);
+    Gemm::multiply(m, n, k, a.data(), k, b.data(), n, fused.data(), n, { bias.data(), square });
+
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const float expected = (plain[i * n + j] + bias[j]) * (plain[i * n + j] + bias[j]);
+            TEST_ASSERT_TRUE(std::fabs(expected - fused[i * n + j]) <= 1e-4f * std::fabs(expected) + 1e-4f);
+        }
+    }
+}
+
+TEST(test_TransposedMultiplyShouldMatchReference) {
+    const Transpose flags[] = { Transpose::No, Transpose::Yes };
+    for (const Transpose transposeA : flags) {
+        for (const Transpose transposeB : flags) {
+            // Small, blocked with ragged edges, and large enough to run in parallel tiles.
+            TEST_ASSERT_TRUE(transposedMultiplyMatchesReference(5, 7, 3, transposeA, transposeB));
+            TEST_ASSERT_TRUE(transposedMultiplyMatchesReference(37, 53, 71, transposeA, transposeB));
+            TEST_ASSERT_TRUE(transposedMultiplyMatchesReference(150, 141, 300, transposeA, transposeB));
+        }
+    }
+}
+
+TEST(test_TransposeShouldMatchElementwiseTranspose) {
+    const int rows = 70;
+    const int cols = 45;
+    const std::vector<float> a = makeValues(rows * cols, 4);
+    // Output rows padded to 80 floats.
+    std::vector<float> b(cols * 80, -5.f);
+
+    Gemm::transpose(rows, cols, a.data(), cols, b.data(), 80);
+
+    const std::vector<float> expected = transposedCopy(rows, cols, a);
+    bool matches = true;
+    for (int j = 0; j < cols; ++j) {
+        for (int i = 0; i < rows; ++i) {
+            matches = matches && b[j * 80 + i] == expected[j * rows + i];
+        }
+        matches = matches && b[j * 80 + rows] == -5.f;
+    }
+    TEST_ASSERT_TRUE(matches);
+}
+
+TEST(test_BatchedMultiplyShouldMatchSeparateProducts) {
+    // Three 5x7 * 7x6 products: A is shared, B and the biases are interleaved, C entries sit side by side.
+    const int batch = 3;
+    const std::vector<float> a = makeValues(5 * 7, 1);
+    const std::vector<float> b = makeValues(batch * 7 * 6, 2);
+    const std::vector<float> bias = makeValues(batch * 6, 3);
+    std::vector<float> c(5 * batch * 6, 123.f);
+
+    Gemm::multiplyBatched(
+        batch, 5, 6, 7,
+        a.data(), 7, 0,
+        b.data(), 6, 7 * 6,
+        c.data(), batch * 6, 6,
+        { bias.data(), nullptr }, 6
+    );
+
+    for (int i = 0; i < batch; ++i) {
+        std::vector<float> expected(5 * 6);
+        Gemm::multiply(5, 6, 7, a.data(), 7, b.data() + i * 7 * 6, 6, expected.data(), 6, { bias.data() + i * 6, nullptr });
+        for (int r = 0; r < 5; ++r) {
+            for (int j = 0; j < 6; ++j) {
+                TEST_ASSERT_EQUAL_FLOAT(expected[r * 6 + j], c[r * batch * 6 + i * 6 + j]);
+            }
+        }
+    }
+}
+
+int main() {
+    return RunTests();
+}
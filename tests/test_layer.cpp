@@ -3,7 +3,9 @@ extern "C" {
 #include "toasty.h"
 }
 #include "activation_function.hpp"
+#include <cmath>
 #include "layer.hpp"
+#include "random.hpp"
 
 using namespace nnn;
 
@@ -60,6 +62,104 @@ TEST(test_ForwardMethowShouldWorkProperly) {
     }
 }
 
+TEST(test_ForwardShouldApplyLayerActivation) {
+    Layer layer(2, 3, Activation::ReLU);
+    layer.weights.fill(-1.f);
+    layer.biases.fill(1.f);
+    layer.biases(0, 2) = 5.f;
+
+    Matrix input(1, 2);
+    input.fill(1.f);
+
+    const Matrix output = layer.forward(input);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.f, output(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.f, output(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(3.f, output(0, 2));
+}
+
+TEST(test_BackwardShouldMatchFiniteDifferences) {
+    Layer layer(3, 4, Activation::Tanh);
+    Random random(3);
+    layer.randomize(-1.f, 1.f, random);
+    Matrix input(2, 3, { 0.5f, -1.f, 0.25f, 1.5f, 0.f, -0.75f });
+    // Weights of the loss sum(lossWeights * outputs), so the output gradients are these weights.
+    const Matrix lossWeights(2, 4, { 1.f, -0.5f, 0.25f, 2.f, -1.f, 0.5f, 1.5f, -0.25f });
+    const auto loss = [&]() {
+        const Matrix output = layer.forward(input);
+        double sum = 0.0;
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                sum += lossWeights(i, j) * output(i, j);
+            }
+        }
+        return sum;
+    };
+    const auto derivative = [&](float& value) {
+        constexpr float h = 1e-3f;
+        const float original = value;
+        value = original + h;
+        const double up = loss();
+        value = original - h;
+        const double down = loss();
+        value = original;
+        return (up - down) / (2.f * h);
+    };
+
+    layer.forwardTraining(input);
+    Matrix outputGradients = lossWeights;
+    Matrix weightGradients(3, 4);
+    Matrix biasGradients(1, 4);
+    Matrix inputGradients;
+    layer.backward(outputGradients, weightGradients, biasGradients, &inputGradients);
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            TEST_ASSERT_TRUE(std::fabs(derivative(layer.weights(i, j)) - weightGradients(i, j)) < 1e-3);
+        }
+    }
+    for (int j = 0; j < 4; ++j) {
+        TEST_ASSERT_TRUE(std::fabs(derivative(layer.biases(0, j)) - biasGradients(0, j)) < 1e-3);
+    }
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            TEST_ASSERT_TRUE(std::fabs(derivative(input(i, j)) - inputGradients(i, j)) < 1e-3);
+        }
+    }
+}
+
+TEST(test_DoubleLayerBackwardShouldMatchFiniteDifferences) {
+    // Double precision allows a far smaller step and tolerance than the float test above.
+    BasicLayer<double> layer(3, 2, Activation::GELU);
+    Random random(4);
+    layer.randomize(-1.0, 1.0, random);
+    const DoubleMatrix input(2, 3, { 0.5, -1.0, 0.25, 1.5, 0.0, -0.75 });
+    const auto loss = [&]() {
+        const DoubleMatrix output = layer.forward(input);
+        return output(0, 0) - 2.0 * output(0, 1) + 0.5 * output(1, 0) + output(1, 1);
+    };
+
+    layer.forwardTraining(input);
+    DoubleMatrix outputGradients(2, 2, { 1.0, -2.0, 0.5, 1.0 });
+    DoubleMatrix weightGradients;
+    DoubleMatrix biasGradients;
+    layer.backward(outputGradients, weightGradients, biasGradients, nullptr);
+
+    constexpr double h = 1e-6;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            double& weight = layer.weights(i, j);
+            const double original = weight;
+            weight = original + h;
+            const double up = loss();
+            weight = original - h;
+            const double down = loss();
+            weight = original;
+            TEST_ASSERT_TRUE(std::fabs((up - down) / (2.0 * h) - weightGradients(i, j)) < 1e-8);
+        }
+    }
+}
+
 int main() {
     return RunTests();
 }
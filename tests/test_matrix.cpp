@@ -1,4 +1,6 @@
 #define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include <cstdint>
 extern "C" {
 #include "toasty.h"
 }
@@ -362,6 +364,312 @@ TEST(test_TranspositionShouldCreateNewTransposedMatrix) {
     }
 }
 
+TEST(test_RawAccessorsShouldExposeRowMajorStorage) {
+    Matrix matrix(2, 3, { 0.f, 1.f, 2.f, 3.f, 4.f, 5.f });
+    const Matrix& constMatrix = matrix;
+
+    TEST_ASSERT_TRUE(matrix.data() == constMatrix.data());
+    TEST_ASSERT_TRUE(matrix.rowData(1) == matrix.data() + 3);
+    TEST_ASSERT_EQUAL(6, constMatrix.span().size());
+    TEST_ASSERT_EQUAL(3, constMatrix.rowSpan(1).size());
+    TEST_ASSERT_EQUAL_FLOAT(4.f, constMatrix.rowSpan(1)[1]);
+
+    matrix.rowSpan(0)[2] = 7.f;
+    TEST_ASSERT_EQUAL_FLOAT(7.f, matrix(0, 2));
+}
+
+TEST(test_ChainedExpressionShouldEvaluateElementwise) {
+    const Matrix a(2, 2, { 5.f, 6.f, 7.f, 8.f });
+    const Matrix b(2, 2, { 1.f, 2.f, 3.f, 4.f });
+    const Matrix c(2, 2, { 1.f, -1.f, 2.f, -2.f });
+
+    const Matrix result = (a - b).elementwiseMultiply(c) * 0.5f + b;
+
+    TEST_ASSERT_EQUAL_FLOAT(3.f, result(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.f, result(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(7.f, result(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.f, result(1, 1));
+}
+
+TEST(test_AdditionShouldBroadcastSingleRow) {
+    const Matrix a(2, 2, { 1.f, 2.f, 3.f, 4.f });
+    const Matrix row(1, 2, { 10.f, 20.f });
+
+    const Matrix result = a * 2.f + row;
+
+    TEST_ASSERT_EQUAL(2, result.getRows());
+    TEST_ASSERT_EQUAL_FLOAT(12.f, result(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(24.f, result(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(16.f, result(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(28.f, result(1, 1));
+}
+
+TEST(test_CompoundAssignmentShouldAcceptExpressions) {
+    Matrix weights(1, 2, { 1.f, 1.f });
+    const Matrix gradient(1, 2, { 2.f, 4.f });
+    const Matrix velocity(1, 2, { 1.f, 1.f });
+
+    weights -= gradient * 0.5f + velocity;
+
+    TEST_ASSERT_EQUAL_FLOAT(-1.f, weights(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(-2.f, weights(0, 1));
+}
+
+TEST(test_AssigningTransposeOfItselfShouldNotCorruptMatrix) {
+    Matrix matrix(2, 2, { 1.f, 2.f, 3.f, 4.f });
+
+    matrix = matrix.transposed();
+
+    TEST_ASSERT_EQUAL_FLOAT(1.f, matrix(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(3.f, matrix(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(2.f, matrix(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(4.f, matrix(1, 1));
+}
+
+TEST(test_MultiplicationShouldAcceptLazyOperands) {
+    const Matrix a(1, 2, { 1.f, 2.f });
+    const Matrix b(2, 1, { 3.f, 4.f });
+
+    const Matrix result = (a * 2.f) * b.transposed().transposed();
+
+    TEST_ASSERT_EQUAL(1, result.getRows());
+    TEST_ASSERT_EQUAL(1, result.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(22.f, result(0, 0));
+}
+
+TEST(test_IntoOperationsShouldReuseDestinationBuffer) {
+    const Matrix a(2, 2, { 1.f, 2.f, 3.f, 4.f });
+    const Matrix b(2, 2, { 1.f, 0.f, 0.f, 1.f });
+    Matrix out(4, 4);
+    const float* buffer = out.data();
+
+    Matrix::multiplyInto(out, a, b);
+    TEST_ASSERT_TRUE(buffer == out.data());
+    TEST_ASSERT_EQUAL(2, out.getRows());
+    TEST_ASSERT_EQUAL(2, out.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(3.f, out(1, 0));
+
+    Matrix::addInto(out, out, b);
+    TEST_ASSERT_TRUE(buffer == out.data());
+    TEST_ASSERT_EQUAL_FLOAT(2.f, out(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(5.f, out(1, 1));
+}
+
+TEST(test_WideMatrixShouldPadRowsToCacheLines) {
+    Matrix matrix(3, 70);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 70; ++j) {
+            matrix(i, j) = static_cast<float>(i * 70 + j);
+        }
+    }
+
+    TEST_ASSERT_EQUAL(70, matrix.getCols());
+    TEST_ASSERT_EQUAL(80, matrix.getStride());
+    TEST_ASSERT_TRUE(matrix.rowData(1) == matrix.data() + 80);
+    TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(matrix.rowData(2)) % 64);
+    TEST_ASSERT_EQUAL(70, matrix.rowSpan(2).size());
+
+    const Matrix copy = matrix + matrix;
+    TEST_ASSERT_EQUAL(80, copy.getStride());
+    TEST_ASSERT_EQUAL_FLOAT(2.f * 139.f, copy(1, 69));
+    TEST_ASSERT_EQUAL_FLOAT(2.f * 140.f, copy(2, 0));
+}
+
+TEST(test_MultiplicationShouldHonorPaddedStrides) {
+    Matrix a(2, 70);
+    Matrix b(70, 65);
+    a.fill(1.f);
+    for (int i = 0; i < 70; ++i) {
+        b(i, 64) = static_cast<float>(i);
+    }
+
+    const Matrix result = a * b;
+
+    TEST_ASSERT_EQUAL(2, result.getRows());
+    TEST_ASSERT_EQUAL(65, result.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(0.f, result(1, 63));
+    TEST_ASSERT_EQUAL_FLOAT(2415.f, result(1, 64));
+}
+
+TEST(test_ProductsWithTransposedOperandsShouldReadThemInPlace) {
+    const Matrix a(3, 2, { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f });
+    const Matrix b(3, 2, { 1.f, 0.f, 0.f, 1.f, 1.f, 1.f });
+
+    // a^T * b: 2x2
+    const Matrix gram = a.transposed() * b;
+    TEST_ASSERT_EQUAL(2, gram.getRows());
+    TEST_ASSERT_EQUAL(2, gram.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(6.f, gram(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(8.f, gram(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(8.f, gram(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(10.f, gram(1, 1));
+
+    // a * b^T: 3x3
+    Matrix outer;
+    Matrix::multiplyInto(outer, a, Transpose::No, b, Transpose::Yes);
+    TEST_ASSERT_EQUAL(3, outer.getRows());
+    TEST_ASSERT_EQUAL_FLOAT(1.f, outer(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(3.f, outer(0, 2));
+    TEST_ASSERT_EQUAL_FLOAT(11.f, outer(2, 2));
+}
+
+TEST(test_TransposeIntoShouldHandlePaddedMatrices) {
+    Matrix a(3, 70);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 70; ++j) {
+            a(i, j) = static_cast<float>(i * 100 + j);
+        }
+    }
+
+    Matrix t;
+    Matrix::transposeInto(t, a);
+    const Matrix back = t.transposed();
+
+    TEST_ASSERT_EQUAL(70, t.getRows());
+    TEST_ASSERT_EQUAL(3, t.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(269.f, t(69, 2));
+    TEST_ASSERT_EQUAL(80, back.getStride());
+    TEST_ASSERT_EQUAL_FLOAT(269.f, back(2, 69));
+}
+
+TEST(test_ViewShouldWriteThroughAndCopiesShouldOwnTheirStorage) {
+    float buffer[6] = { 1.f, 2.f, 0.f, 3.f, 4.f, 0.f };
+    Matrix view = Matrix::view(buffer, 2, 2, 3);
+
+    TEST_ASSERT_TRUE(view.isView());
+    TEST_ASSERT_FALSE(view.hasPaddedLayout());
+    TEST_ASSERT_EQUAL(3, view.getStride());
+    TEST_ASSERT_EQUAL_FLOAT(3.f, view(1, 0));
+
+    Matrix copy = view;
+    TEST_ASSERT_FALSE(copy.isView());
+    const float expected[4] = { 1.f, 2.f, 3.f, 4.f };
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], copy(i / 2, i % 2));
+    }
+    Matrix assigned(2, 2);
+    assigned = view;
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], assigned(i / 2, i % 2));
+    }
+    copy(0, 0) = 10.f;
+    TEST_ASSERT_EQUAL_FLOAT(1.f, buffer[0]);
+
+    view = Matrix(2, 2, { 5.f, 6.f, 7.f, 8.f });
+    TEST_ASSERT_TRUE(view.isView());
+    TEST_ASSERT_EQUAL_FLOAT(7.f, buffer[3]);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.f, buffer[2]);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, buffer[5]);
+
+    try {
+        Matrix invalid = Matrix::view(buffer, 2, 3, 2);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+}
+
+TEST(test_ViewShouldKeepItsShapeUnlessRebound) {
+    float buffer[8] = { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f };
+    Matrix view = Matrix::view(buffer, 2, 2, 2);
+    const Matrix smaller(1, 2, { 9.f, 9.f });
+    int failures = 0;
+    const auto expectThrow = [&](auto assign) {
+        try {
+            assign();
+        } catch (std::runtime_error& e) {
+            (void) e;
+            ++failures;
+        }
+    };
+    expectThrow([&] { view = smaller; });
+    expectThrow([&] { view = Matrix(1, 2); });
+    expectThrow([&] { view = smaller * 2.f; });
+    expectThrow([&] { Matrix::multiplyInto(view, smaller, Matrix(2, 1)); });
+    TEST_ASSERT_EQUAL(4, failures);
+    TEST_ASSERT_TRUE(view.isView());
+    TEST_ASSERT_EQUAL(2, view.getRows());
+    TEST_ASSERT_EQUAL_FLOAT(3.f, buffer[2]);
+
+    view.rebind(Matrix::view(buffer + 4, 1, 4, 4));
+    TEST_ASSERT_EQUAL(4, view.getCols());
+    TEST_ASSERT_EQUAL_FLOAT(5.f, view(0, 0));
+    view.rebind(Matrix(3, 3));
+    TEST_ASSERT_FALSE(view.isView());
+    view = Matrix::view(buffer, 1, 1, 1);
+    view.reset();
+    TEST_ASSERT_FALSE(view.isView());
+    TEST_ASSERT_EQUAL(0, view.getRows());
+    const float expected[8] = { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f };
+    for (int i = 0; i < 8; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], buffer[i]);
+    }
+}
+
+TEST(test_CompoundOperatorsShouldSkipTheGapsOfStridedViews) {
+    float buffer[6] = { 1.f, 2.f, -1.f, 3.f, 4.f, -1.f };
+    Matrix view = Matrix::view(buffer, 2, 2, 3);
+    Matrix other(2, 2, { 30.f, 40.f, 30.f, 40.f });
+
+    other -= view;
+    TEST_ASSERT_EQUAL_FLOAT(29.f, other(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(38.f, other(0, 1));
+    TEST_ASSERT_EQUAL_FLOAT(27.f, other(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(36.f, other(1, 1));
+
+    other += view;
+    TEST_ASSERT_EQUAL_FLOAT(30.f, other(1, 0));
+    TEST_ASSERT_EQUAL_FLOAT(40.f, other(1, 1));
+
+    view += Matrix(1, 2, { 10.f, 20.f });
+    view -= Matrix(2, 2, { 1.f, 1.f, 1.f, 1.f });
+    const float expected[6] = { 10.f, 21.f, -1.f, 12.f, 23.f, -1.f };
+    for (int i = 0; i < 6; ++i) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], buffer[i]);
+    }
+
+    view.fill(0.f);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, buffer[3]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.f, buffer[2]);
+}
+
+TEST(test_DoubleMatrixShouldKeepDoublePrecision) {
+    // 1e-10 is lost in float arithmetic.
+    const DoubleMatrix small(2, 2, { 1.0, 1e-10, 0.0, 1.0 });
+    const DoubleMatrix sum = small + small * 2.0;
+    TEST_ASSERT_TRUE(sum(0, 1) == 3e-10);
+
+    // Wide enough to be padded to the double cache line, and large enough to take several register tiles.
+    DoubleMatrix a(9, 70);
+    DoubleMatrix b(70, 11);
+    for (int i = 0; i < 9; ++i) {
+        for (int k = 0; k < 70; ++k) {
+            a(i, k) = 1.0 + (i * 70 + k) * 1e-9;
+        }
+    }
+    for (int k = 0; k < 70; ++k) {
+        for (int j = 0; j < 11; ++j) {
+            b(k, j) = k - j * 1e-9;
+        }
+    }
+    TEST_ASSERT_EQUAL(72, a.getStride());
+
+    const DoubleMatrix product = a * b;
+    DoubleMatrix transposedProduct;
+    DoubleMatrix::multiplyInto(transposedProduct, b, Transpose::Yes, a, Transpose::Yes);
+    for (int i = 0; i < 9; ++i) {
+        for (int j = 0; j < 11; ++j) {
+            double expected = 0.0;
+            for (int k = 0; k < 70; ++k) {
+                expected += a(i, k) * b(k, j);
+            }
+            TEST_ASSERT_TRUE(std::fabs(product(i, j) - expected) < 1e-9);
+            TEST_ASSERT_TRUE(std::fabs(transposedProduct(j, i) - expected) < 1e-9);
+        }
+    }
+}
+
 int main() {
     return RunTests();
 }
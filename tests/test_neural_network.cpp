@@ -1,11 +1,19 @@
 #define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 extern "C" {
 #include "toasty.h"
 }
 #include "activation_function.hpp"
 #include "neural_network.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include <utility>
 
 using namespace nnn;
 
@@ -70,6 +78,185 @@ TEST(test_PredictionShouldCalculateOutputMatrixProperly) {
     TEST_ASSERT_EQUAL_FLOAT(withSigmoid(0, 0), output(0, 0));
 }
 
+TEST(test_PredictIntoShouldReuseOutputBufferAndMatchPredict) {
+    NeuralNetwork nn({ 3, 5, 4, 2 });
+    nn.randomize(-1.f, 1.f);
+
+    Matrix input(8, 3);
+    input.randomize(-1.f, 1.f);
+
+    const Matrix expected = nn.predict(input);
+    Matrix output;
+    nn.predict(input, output);
+    const float* buffer = output.data();
+    nn.predict(input, output);
+
+    TEST_ASSERT_TRUE(buffer == output.data());
+    TEST_ASSERT_EQUAL(8, output.getRows());
+    TEST_ASSERT_EQUAL(2, output.getCols());
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            TEST_ASSERT_EQUAL_FLOAT(expected(i, j), output(i, j));
+        }
+    }
+}
+
+TEST(test_TrainingShouldNotDependOnThreadCount) {
+    const Matrix inputs(4, 2, { 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f });
+    const Matrix targets(4, 1, { 0.f, 1.f, 1.f, 0.f });
+    NeuralNetwork initial({ 2, 3, 1 });
+    initial.randomize(-1.f, 1.f);
+
+    NeuralNetwork serial = initial;
+    ThreadPool::setThreadCount(1);
+    Random::setGlobalSeed(42);
+    serial.train(inputs, targets, 5, 0.1f);
+
+    NeuralNetwork parallel = initial;
+    ThreadPool::setThreadCount(4);
+    Random::setGlobalSeed(42);
+    parallel.train(inputs, targets, 5, 0.1f);
+    ThreadPool::setThreadCount(0);
+
+    const Matrix expected = serial.predict(inputs);
+    const Matrix actual = parallel.predict(inputs);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(expected(i, 0) == actual(i, 0));
+    }
+}
+
+TEST(test_LayersShouldBeViewsIntoOneParameterBuffer) {
+    NeuralNetwork nn({ 2, 70, 1 });
+    nn.randomize(-1.f, 1.f);
+
+    auto inspector = reinterpret_cast<NeuralNetworkInspector*>(&nn);
+    const std::span<const float> parameters = std::as_const(nn).getParameters();
+    for (const Layer& layer : inspector->layers) {
+        TEST_ASSERT_TRUE(layer.weights.isView());
+        TEST_ASSERT_TRUE(layer.biases.isView());
+        TEST_ASSERT_TRUE(layer.weights.data() >= parameters.data());
+        TEST_ASSERT_TRUE(layer.biases.data() + layer.biases.getCols() <= parameters.data() + parameters.size());
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(layer.weights.data()) % 64);
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(layer.biases.data()) % 64);
+    }
+    TEST_ASSERT_EQUAL(80, inspector->layers[0].weights.getStride());
+
+    NeuralNetwork copy = nn;
+    auto copyInspector = reinterpret_cast<NeuralNetworkInspector*>(&copy);
+    TEST_ASSERT_TRUE(copyInspector->layers[1].weights.isView());
+    TEST_ASSERT_EQUAL_FLOAT(inspector->layers[1].weights(69, 0), copyInspector->layers[1].weights(69, 0));
+
+    for (float& parameter : copy.getParameters()) {
+        parameter = 0.f;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.f, copyInspector->layers[0].biases(0, 5));
+    TEST_ASSERT_TRUE(inspector->layers[0].biases(0, 5) != 0.f);
+
+    // Same-shaped assignments write into the parameter buffer; others would corrupt it or detach the layer.
+    copyInspector->layers[1].biases = Matrix(1, 1, { 3.f });
+    const float* bias = copyInspector->layers[1].biases.data();
+    TEST_ASSERT_EQUAL_FLOAT(3.f, copy.getParameters()[bias - copy.getParameters().data()]);
+    try {
+        copyInspector->layers[1].weights = Matrix(2, 1);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+    TEST_ASSERT_TRUE(copyInspector->layers[1].weights.isView());
+    TEST_ASSERT_EQUAL(70, copyInspector->layers[1].weights.getRows());
+}
+
+TEST(test_BackpropagationShouldLearnXor) {
+    const Matrix inputs(4, 2, { 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f });
+    const Matrix targets(4, 1, { 0.f, 1.f, 1.f, 0.f });
+    const OptimizerType optimizers[] = { OptimizerType::Sgd, OptimizerType::Momentum, OptimizerType::Adam };
+    const float learningRates[] = { 2.f, 0.5f, 0.05f };
+
+    for (int o = 0; o < 3; ++o) {
+        NeuralNetwork nn({ 2, 8, 1 }, { Activation::Tanh, Activation::Sigmoid });
+        nn.randomize(-1.f, 1.f, Random(7));
+        Random::setGlobalSeed(7);
+        nn.train(inputs, targets, 1000, learningRates[o], TrainingMode::Backpropagation, optimizers[o], 2);
+
+        const Matrix predictions = nn.predict(inputs);
+        for (int i = 0; i < 4; ++i) {
+            TEST_ASSERT_TRUE(std::fabs(predictions(i, 0) - targets(i, 0)) < 0.2f);
+        }
+    }
+}
+
+TEST(test_SavedNetworkShouldLoadWithSamePredictions) {
+    const std::string path = (std::filesystem::temp_directory_path() / "nnn_test_model.bin").string();
+    NeuralNetwork nn({ 3, 70, 2 }, { Activation::ReLU, Activation::Softmax });
+    nn.randomize(-1.f, 1.f, Random(11));
+    nn.save(path);
+
+    const Matrix input(2, 3, { 0.5f, -1.f, 2.f, 0.f, 0.25f, -0.75f });
+    const Matrix expected = nn.predict(input);
+    for (const LoadMode mode : { LoadMode::Copy, LoadMode::Map }) {
+        NeuralNetwork loaded = NeuralNetwork::load(path, mode);
+        TEST_ASSERT_EQUAL(nn.getParameters().size(), loaded.getParameters().size());
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(loaded.getParameters().data()) % 64);
+        const Matrix output = loaded.predict(input);
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                TEST_ASSERT_EQUAL_FLOAT(expected(i, j), output(i, j));
+            }
+        }
+
+        // Copies own their parameters, even of a mapped network, and assigning over a mapped network replaces
+        // its view instead of writing through it.
+        NeuralNetwork copy = loaded;
+        TEST_ASSERT_TRUE(copy.getParameters().data() != loaded.getParameters().data());
+        copy.randomize(-1.f, 1.f, Random(12));
+        const float first = copy.getParameters()[0];
+        loaded = std::move(copy);
+        TEST_ASSERT_EQUAL_FLOAT(first, loaded.getParameters()[0]);
+        TEST_ASSERT_EQUAL_FLOAT(nn.getParameters()[0], NeuralNetwork::load(path, mode).getParameters()[0]);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(test_LoadingCorruptModelShouldFail) {
+    const std::string path = (std::filesystem::temp_directory_path() / "nnn_test_corrupt_model.bin").string();
+    NeuralNetwork nn({ 2, 4, 1 });
+    nn.save(path);
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(-4, std::ios::end);
+        stream.write("\x7f\x7f\x7f\x7f", 4);
+    }
+
+    try {
+        (void) NeuralNetwork::load(path);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+    // Without verification a mapped load trusts the file.
+    TEST_ASSERT_EQUAL(3, NeuralNetwork::load(path, LoadMode::Map, false).predict(Matrix(3, 2)).getRows());
+
+    // A parameter count whose byte size wraps around, with a layer large enough to match it.
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        const std::uint64_t parameterCount = std::uint64_t(1) << 62;
+        const std::uint32_t inputSize = INT32_MAX;
+        stream.seekp(24);
+        stream.write(reinterpret_cast<const char*>(&parameterCount), sizeof(parameterCount));
+        stream.seekp(64);
+        stream.write(reinterpret_cast<const char*>(&inputSize), sizeof(inputSize));
+    }
+    try {
+        (void) NeuralNetwork::load(path, LoadMode::Map, false);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+
+    std::filesystem::remove(path);
+}
+
 int main() {
     return RunTests();
 }
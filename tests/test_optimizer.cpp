@@ -0,0 +1,63 @@
+#define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include "optimizer.hpp"
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+TEST(test_SgdShouldStepAgainstGradient) {
+    std::vector<float> parameters = { 1.f, -2.f };
+    const std::vector<float> gradients = { 0.5f, -1.f };
+    Optimizer optimizer(OptimizerType::Sgd, 0.1f, parameters.size());
+
+    optimizer.step(parameters, gradients);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.95f, parameters[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.9f, parameters[1]);
+}
+
+TEST(test_MomentumShouldAccumulateVelocity) {
+    std::vector<float> parameters = { 0.f };
+    const std::vector<float> gradients = { 1.f };
+    Optimizer optimizer(OptimizerType::Momentum, 0.1f, parameters.size());
+
+    optimizer.step(parameters, gradients);
+    optimizer.step(parameters, gradients);
+
+    // Velocities 1 and 0.9 * 1 + 1.
+    TEST_ASSERT_EQUAL_FLOAT(-0.1f - 0.19f, parameters[0]);
+}
+
+TEST(test_AdamFirstStepShouldMoveByLearningRate) {
+    std::vector<float> parameters = { 0.f, 0.f, 0.f };
+    const std::vector<float> gradients = { 1e-3f, -20.f, 0.f };
+    Optimizer optimizer(OptimizerType::Adam, 0.01f, parameters.size());
+
+    optimizer.step(parameters, gradients);
+
+    TEST_ASSERT_TRUE(std::fabs(parameters[0] + 0.01f) < 1e-6f);
+    TEST_ASSERT_TRUE(std::fabs(parameters[1] - 0.01f) < 1e-6f);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, parameters[2]);
+}
+
+TEST(test_StepShouldRejectMismatchedSizes) {
+    std::vector<float> parameters = { 0.f, 0.f };
+    const std::vector<float> gradients = { 1.f };
+    Optimizer optimizer(OptimizerType::Adam, 0.01f, parameters.size());
+
+    try {
+        optimizer.step(parameters, gradients);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,81 @@
+#define TOASTY_IMPLEMENTATION
+#include "activation_function.hpp"
+#include <cmath>
+#include <cstdint>
+#include "loss_function.hpp"
+#include "neural_network.hpp"
+#include "population.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+TEST(test_PopulationShouldStartAsCopiesOfPrototype) {
+    NeuralNetwork prototype({ 3, 70, 2 });
+    prototype.randomize(-1.f, 1.f, Random(1));
+
+    Population population(prototype, 5);
+
+    TEST_ASSERT_EQUAL(5, population.size());
+    TEST_ASSERT_EQUAL(prototype.getParameters().size(), population.parameterCount());
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<std::uintptr_t>(population.parameters(i).data()) % 64);
+        TEST_ASSERT_EQUAL_FLOAT(prototype.getParameters()[17], population.parameters(i)[17]);
+    }
+}
+
+TEST(test_EvaluateShouldMatchPredictionOfEachIndividual) {
+    const Matrix inputs(4, 2, { 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f });
+    const Matrix targets(4, 3, { 1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f });
+    NeuralNetwork prototype({ 2, 70, 5, 3 }, { Activation::ReLU, Activation::Tanh, Activation::Softmax });
+    Population population(prototype, 6);
+    for (int i = 0; i < 6; ++i) {
+        Random random(5, i);
+        random.fillUniform(population.parameters(i), -1.f, 1.f);
+    }
+
+    std::vector<float> scores(6);
+    ThreadPool::setThreadCount(4);
+    population.evaluate(inputs, targets, scores);
+    ThreadPool::setThreadCount(0);
+
+    for (int i = 0; i < 6; ++i) {
+        NeuralNetwork network = prototype;
+        population.copyTo(i, network);
+        const float expected = LossFunction::meanSquaredError(network.predict(inputs), targets);
+        TEST_ASSERT_TRUE(std::fabs(scores[i] - expected) <= 1e-5f * expected);
+    }
+}
+
+TEST(test_BreedShouldCopyParentsIntoNextGeneration) {
+    NeuralNetwork prototype({ 2, 3, 1 });
+    Population population(prototype, 4);
+    for (int i = 0; i < 4; ++i) {
+        population.parameters(i)[0] = static_cast<float>(i);
+    }
+    const float* before = population.parameters(0).data();
+
+    const std::vector<int> parents = { 3, 1 };
+    Random random(9);
+    population.breed(parents, 0.f, random);
+
+    TEST_ASSERT_TRUE(population.parameters(0).data() != before);
+    TEST_ASSERT_EQUAL_FLOAT(3.f, population.parameters(0)[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1.f, population.parameters(1)[0]);
+    for (int i = 2; i < 4; ++i) {
+        const float value = population.parameters(i)[0];
+        TEST_ASSERT_TRUE(value == 3.f || value == 1.f);
+    }
+
+    population.breed(parents, 0.f, random);
+    TEST_ASSERT_TRUE(population.parameters(0).data() == before);
+}
+
+int main() {
+    return RunTests();
+}
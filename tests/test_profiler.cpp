@@ -0,0 +1,94 @@
+#define TOASTY_IMPLEMENTATION
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "neural_network.hpp"
+#include "profiler.hpp"
+#include <string>
+#include "thread_pool.hpp"
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static const ProfileZone* findZone(const ProfileSnapshot& snapshot, const std::string& name, int index = -1) {
+    const auto zone = std::find_if(snapshot.zones.begin(), snapshot.zones.end(), [&](const ProfileZone& zone) {
+        return zone.name == name && zone.index == index;
+    });
+    return zone == snapshot.zones.end() ? nullptr : &*zone;
+}
+
+TEST(test_PredictShouldRecordZonesAndCounters) {
+    NeuralNetwork nn({ 3, 5, 2 });
+    const Matrix input(4, 3);
+    Matrix output;
+    Profiler::reset();
+    nn.predict(input, output);
+    nn.predict(input, output);
+    const ProfileSnapshot snapshot = Profiler::snapshot();
+
+    if constexpr (!Profiler::ENABLED) {
+        TEST_ASSERT_TRUE(snapshot.zones.empty());
+        TEST_ASSERT_EQUAL(0, snapshot.flops);
+        return;
+    }
+    const ProfileZone* predict = findZone(snapshot, "predict");
+    const ProfileZone* first = findZone(snapshot, "layer.forward", 0);
+    const ProfileZone* second = findZone(snapshot, "layer.forward", 1);
+    TEST_ASSERT_TRUE(predict != nullptr && first != nullptr && second != nullptr);
+    TEST_ASSERT_EQUAL(2, predict->calls);
+    TEST_ASSERT_EQUAL(2, second->calls);
+    TEST_ASSERT_TRUE(predict->totalNs >= first->totalNs + second->totalNs);
+    TEST_ASSERT_EQUAL(4, findZone(snapshot, "gemm")->calls);
+    // Two predictions of 4 samples through 3x5 and 5x2 products.
+    TEST_ASSERT_EQUAL(2 * 2 * (4 * 5 * 3 + 4 * 2 * 5), snapshot.flops);
+    // The output and the hidden buffer are allocated by the first call only.
+    TEST_ASSERT_EQUAL(2, snapshot.matrixAllocations);
+}
+
+TEST(test_ZonesShouldBeMergedAcrossThreads) {
+    ThreadPool::setThreadCount(4);
+    Profiler::reset();
+    ThreadPool::parallelFor(64, 1, [](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            NNN_PROFILE_SCOPE("test.task");
+            NNN_PROFILE_COUNT(Bytes, 1);
+        }
+    });
+    const ProfileSnapshot snapshot = Profiler::snapshot();
+    ThreadPool::setThreadCount(0);
+
+    if constexpr (Profiler::ENABLED) {
+        TEST_ASSERT_EQUAL(64, findZone(snapshot, "test.task")->calls);
+        TEST_ASSERT_EQUAL(64, snapshot.bytes);
+    } else {
+        TEST_ASSERT_TRUE(findZone(snapshot, "test.task") == nullptr);
+    }
+}
+
+TEST(test_ChromeTraceShouldListCompleteEvents) {
+    NeuralNetwork nn({ 2, 3, 1 });
+    Profiler::reset();
+    (void) nn.predict(Matrix(1, 2));
+    const std::string path = (std::filesystem::temp_directory_path() / "nnn_test_trace.json").string();
+    Profiler::writeChromeTrace(path);
+
+    std::ifstream stream(path);
+    const std::string trace((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    TEST_ASSERT_EQUAL(0, trace.find("{\"traceEvents\": ["));
+    TEST_ASSERT_TRUE(trace.find("\"otherData\"") != std::string::npos);
+    const bool hasLayerEvent = trace.find(
+        "{\"name\": \"layer.forward\", \"cat\": \"nnn\", \"ph\": \"X\""
+    ) != std::string::npos;
+    TEST_ASSERT_TRUE(hasLayerEvent == Profiler::ENABLED);
+    TEST_ASSERT_TRUE((trace.find("\"args\": {\"index\": 1}") != std::string::npos) == Profiler::ENABLED);
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    return RunTests();
+}
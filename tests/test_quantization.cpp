@@ -0,0 +1,110 @@
+#define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include <cstdint>
+#include "gemm.hpp"
+#include <limits>
+#include "neural_network.hpp"
+#include "quantization.hpp"
+#include "random.hpp"
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static float maxDifference(const Matrix& a, const Matrix& b) {
+    float difference = 0.f;
+    for (int i = 0; i < a.getRows(); ++i) {
+        for (int j = 0; j < a.getCols(); ++j) {
+            difference = std::fmax(difference, std::fabs(a(i, j) - b(i, j)));
+        }
+    }
+    return difference;
+}
+
+TEST(test_HalfConversionsShouldRoundToNearestEven) {
+    TEST_ASSERT_EQUAL(0x3c00, toFloat16(1.f));
+    TEST_ASSERT_EQUAL(0xc000, toFloat16(-2.f));
+    TEST_ASSERT_EQUAL(0x7bff, toFloat16(65504.f));
+    TEST_ASSERT_EQUAL(0x7c00, toFloat16(1e6f));
+    TEST_ASSERT_EQUAL(0x0001, toFloat16(std::ldexp(1.f, -24)));
+    // 1 + 2^-11 lies halfway between 1 and the next half, and rounds to the even one.
+    TEST_ASSERT_EQUAL(0x3c00, toFloat16(1.f + std::ldexp(1.f, -11)));
+    TEST_ASSERT_TRUE(std::isnan(fromFloat16(toFloat16(std::numeric_limits<float>::quiet_NaN()))));
+
+    for (const float value : { 0.f, 1.f, -0.5f, 3.140625f, 65504.f, std::ldexp(1.f, -24), std::ldexp(3.f, -20) }) {
+        TEST_ASSERT_EQUAL_FLOAT(value, fromFloat16(toFloat16(value)));
+    }
+
+    TEST_ASSERT_EQUAL(0x3f80, toBFloat16(1.f));
+    TEST_ASSERT_EQUAL(0x3f80, toBFloat16(1.f + std::ldexp(1.f, -8)));
+    TEST_ASSERT_EQUAL(0x3f82, toBFloat16(1.f + std::ldexp(3.f, -8)));
+    TEST_ASSERT_EQUAL_FLOAT(-1.5f, fromBFloat16(toBFloat16(-1.5f)));
+    TEST_ASSERT_TRUE(std::isnan(fromBFloat16(toBFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(test_QuantizedLayersShouldApproximateFp32) {
+    Layer layer(70, 9, Activation::Tanh);
+    Random random(3);
+    layer.randomize(-1.f, 1.f, random);
+    Matrix input(7, 70);
+    input.randomize(-1.f, 1.f, random);
+    const Matrix expected = layer.forward(input);
+
+    const GemmKernel kernels[] = { GemmKernel::Scalar, GemmKernel::Auto };
+    for (const GemmKernel kernel : kernels) {
+        TEST_ASSERT_TRUE(Gemm::setKernel(kernel));
+        Matrix output;
+        QuantizedLayer(layer, WeightPrecision::Float16).forwardInto(input, output);
+        TEST_ASSERT_TRUE(maxDifference(expected, output) < 1e-2f);
+        QuantizedLayer(layer, WeightPrecision::BFloat16).forwardInto(input, output);
+        TEST_ASSERT_TRUE(maxDifference(expected, output) < 5e-2f);
+        QuantizedLayer(layer, WeightPrecision::Int8).forwardInto(input, output);
+        TEST_ASSERT_TRUE(maxDifference(expected, output) < 1e-1f);
+    }
+    TEST_ASSERT_TRUE(Gemm::setKernel(GemmKernel::Auto));
+}
+
+TEST(test_Int8KernelsShouldAgreeExactly) {
+    Layer layer(40, 5, Activation::ReLU);
+    Random random(5);
+    layer.randomize(-2.f, 2.f, random);
+    Matrix input(6, 40);
+    input.randomize(-3.f, 3.f, random);
+    const QuantizedLayer quantized(layer, WeightPrecision::Int8);
+
+    TEST_ASSERT_TRUE(Gemm::setKernel(GemmKernel::Scalar));
+    const Matrix scalar = [&] { Matrix output; quantized.forwardInto(input, output); return output; }();
+    TEST_ASSERT_TRUE(Gemm::setKernel(GemmKernel::Auto));
+    const Matrix automatic = [&] { Matrix output; quantized.forwardInto(input, output); return output; }();
+
+    // Integer accumulation makes the result independent of the kernel.
+    TEST_ASSERT_EQUAL_FLOAT(0.f, maxDifference(scalar, automatic));
+}
+
+TEST(test_CalibrationShouldReportDifferenceToFp32) {
+    NeuralNetwork nn({ 64, 64, 4 }, { Activation::ReLU, Activation::Softmax });
+    nn.randomize(-0.2f, 0.2f, Random(8));
+    Random random(9);
+    Matrix samples(50, 64);
+    samples.randomize(-1.f, 1.f, random);
+
+    CalibrationReport report;
+    QuantizedNetwork quantized = QuantizedNetwork::calibrate(nn, WeightPrecision::Int8, samples, report);
+    TEST_ASSERT_TRUE(report.maxAbsoluteError < 0.05f);
+    TEST_ASSERT_TRUE(report.meanAbsoluteError <= report.maxAbsoluteError);
+    TEST_ASSERT_TRUE(report.argmaxAgreement > 0.9f);
+    TEST_ASSERT_TRUE(report.quantizedBytes * 3 < report.fp32Bytes);
+    TEST_ASSERT_EQUAL(report.quantizedBytes, quantized.getWeightBytes());
+    TEST_ASSERT_EQUAL(4, quantized.predict(samples).getCols());
+
+    QuantizedNetwork half = QuantizedNetwork::calibrate(nn, WeightPrecision::Float16, samples, report);
+    TEST_ASSERT_TRUE(report.maxAbsoluteError < 1e-3f);
+    TEST_ASSERT_EQUAL_FLOAT(1.f, report.argmaxAgreement);
+    TEST_ASSERT_TRUE(half.getPrecision() == WeightPrecision::Float16);
+}
+
+int main() {
+    return RunTests();
+}
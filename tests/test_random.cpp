@@ -0,0 +1,116 @@
+#define TOASTY_IMPLEMENTATION
+#include <cmath>
+#include "matrix.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+TEST(test_SameSeedAndStreamShouldReproduceSequence) {
+    Random first(7, 3);
+    Random second(7, 3);
+    Random otherStream(7, 4);
+
+    bool same = true;
+    bool differs = false;
+    for (int i = 0; i < 100; ++i) {
+        const std::uint32_t value = first.nextUint();
+        same = same && value == second.nextUint();
+        differs = differs || value != otherStream.nextUint();
+    }
+    TEST_ASSERT_TRUE(same);
+    TEST_ASSERT_TRUE(differs);
+}
+
+TEST(test_GeneratorShouldMatchPhiloxReferenceVector) {
+    // Philox4x32-10 of counter 0 under key 0: word 0 of the first block comes first.
+    Random random(0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0x6627e8d5u, random.nextUint());
+}
+
+TEST(test_BulkFillShouldMatchScalarDraws) {
+    Random scalar(11);
+    Random bulk(11);
+    std::vector<float> values(37);
+    bulk.fillUniform(values, -1.f, 1.f);
+
+    for (const float value : values) {
+        TEST_ASSERT_EQUAL_FLOAT(scalar.uniform(-1.f, 1.f), value);
+    }
+}
+
+TEST(test_SplitStreamsShouldBeIndependentAndStable) {
+    const Random parent(5);
+    Random a = parent.split(0);
+    Random b = parent.split(1);
+    Random again = parent.split(0);
+
+    const std::uint32_t first = a.nextUint();
+    TEST_ASSERT_TRUE(first != b.nextUint());
+    TEST_ASSERT_EQUAL_UINT32(first, again.nextUint());
+}
+
+TEST(test_LargeFillShouldNotDependOnThreadCount) {
+    std::vector<float> serial(200003);
+    std::vector<float> parallel(serial.size());
+
+    ThreadPool::setThreadCount(1);
+    Random(3).fillNormal(serial, 0.f, 1.f);
+    ThreadPool::setThreadCount(4);
+    Random(3).fillNormal(parallel, 0.f, 1.f);
+    ThreadPool::setThreadCount(0);
+
+    TEST_ASSERT_TRUE(serial == parallel);
+}
+
+TEST(test_FillsShouldFollowRequestedDistributions) {
+    Random random(1);
+    std::vector<float> values(100000);
+
+    random.fillUniform(values, 2.f, 4.f);
+    double sum = 0.0;
+    bool inRange = true;
+    for (const float value : values) {
+        inRange = inRange && value >= 2.f && value <= 4.f;
+        sum += value;
+    }
+    TEST_ASSERT_TRUE(inRange);
+    TEST_ASSERT_TRUE(std::fabs(sum / values.size() - 3.0) < 0.01);
+
+    random.fillNormal(values, 1.f, 2.f);
+    double mean = 0.0;
+    double squares = 0.0;
+    for (const float value : values) {
+        mean += value;
+        squares += static_cast<double>(value) * value;
+    }
+    mean /= values.size();
+    const double variance = squares / values.size() - mean * mean;
+    TEST_ASSERT_TRUE(std::fabs(mean - 1.0) < 0.03);
+    TEST_ASSERT_TRUE(std::fabs(variance - 4.0) < 0.1);
+}
+
+TEST(test_GlobalSeedShouldMakeRandomizeReproducible) {
+    Matrix first(3, 70);
+    Matrix second(3, 70);
+
+    Random::setGlobalSeed(9);
+    first.randomize(-1.f, 1.f);
+    Random::setGlobalSeed(9);
+    second.randomize(-1.f, 1.f);
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 70; ++j) {
+            TEST_ASSERT_EQUAL_FLOAT(first(i, j), second(i, j));
+        }
+    }
+}
+
+int main() {
+    return RunTests();
+}
@@ -0,0 +1,65 @@
+#define TOASTY_IMPLEMENTATION
+#include <array>
+#include <cmath>
+#include "neural_network.hpp"
+#include "random.hpp"
+#include "static_network.hpp"
+#include <stdexcept>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+TEST(test_StaticNetworkShouldKeepParametersInline) {
+    using Network = StaticNetwork<2, 3, 1>;
+    static_assert(Network::LAYER_COUNT == 2);
+    static_assert(Network::INPUT_SIZE == 2 && Network::OUTPUT_SIZE == 1);
+
+    Network network;
+    TEST_ASSERT_EQUAL(2 * 3 + 3 + 3 * 1 + 1, network.getParameters().size());
+    TEST_ASSERT_TRUE(sizeof(Network) < 128);
+    // Zero weights and biases through sigmoid.
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, network.predict({ 1.f, -1.f })[0]);
+}
+
+TEST(test_StaticNetworkShouldMatchNeuralNetwork) {
+    NeuralNetwork nn({ 3, 70, 5, 2 }, { Activation::ReLU, Activation::Tanh, Activation::Softmax });
+    nn.randomize(-1.f, 1.f, Random(21));
+    const StaticNetwork<3, 70, 5, 2> network(nn);
+
+    Matrix input(4, 3, { 0.5f, -1.f, 2.f, 0.f, 0.25f, -0.75f, 1.f, 1.f, 1.f, -2.f, 0.f, 3.f });
+    const Matrix expected = nn.predict(input);
+    Matrix output;
+    network.predict(input, output);
+    for (int i = 0; i < 4; ++i) {
+        const std::array<float, 2> sample = network.predict({ input(i, 0), input(i, 1), input(i, 2) });
+        for (int j = 0; j < 2; ++j) {
+            TEST_ASSERT_TRUE(std::abs(expected(i, j) - output(i, j)) < 1e-5f);
+            TEST_ASSERT_EQUAL_FLOAT(output(i, j), sample[j]);
+        }
+    }
+
+    NeuralNetwork roundTrip = network.toNeuralNetwork();
+    const Matrix converted = roundTrip.predict(input);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            TEST_ASSERT_EQUAL_FLOAT(expected(i, j), converted(i, j));
+        }
+    }
+}
+
+TEST(test_ConvertingMismatchedNetworkShouldFail) {
+    const NeuralNetwork nn({ 2, 4, 1 });
+    try {
+        const StaticNetwork<2, 3, 1> network(nn);
+        TEST_ASSERT_TRUE(false);
+    } catch (std::runtime_error& e) {
+        (void) e;
+    }
+}
+
+int main() {
+    return RunTests();
+}
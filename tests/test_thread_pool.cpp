@@ -0,0 +1,132 @@
+#define TOASTY_IMPLEMENTATION
+#include "activation_function.hpp"
+#include <atomic>
+#include <cstring>
+#include "gemm.hpp"
+#include "matrix.hpp"
+#include <stdexcept>
+#include "thread_pool.hpp"
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static Matrix makeMatrix(int rows, int cols, int seed) {
+    Matrix matrix(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            matrix(i, j) = static_cast<float>((i * 31 + j * 7 + seed * 13) % 23) / 11.f - 1.f;
+        }
+    }
+    return matrix;
+}
+
+static bool bitIdentical(const Matrix& lhs, const Matrix& rhs) {
+    if (lhs.getRows() != rhs.getRows() || lhs.getCols() != rhs.getCols()) {
+        return false;
+    }
+    for (int i = 0; i < lhs.getRows(); ++i) {
+        if (std::memcmp(lhs.rowData(i), rhs.rowData(i), lhs.getCols() * sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(test_ThreadCountShouldBeConfigurable) {
+    ThreadPool::setThreadCount(3);
+    TEST_ASSERT_EQUAL_INT(3, ThreadPool::getThreadCount());
+    ThreadPool::setThreadCount(1);
+    TEST_ASSERT_EQUAL_INT(1, ThreadPool::getThreadCount());
+    ThreadPool::setThreadCount(0);
+    TEST_ASSERT_TRUE(ThreadPool::getThreadCount() >= 1);
+}
+
+TEST(test_ParallelForShouldVisitEveryIndexOnce) {
+    ThreadPool::setThreadCount(4);
+    std::vector<std::atomic<int>> visits(10007);
+    ThreadPool::parallelFor(static_cast<int>(visits.size()), 16, [&](int begin, int end) {
+        // Nested calls run inline on the worker.
+        ThreadPool::parallelFor(end - begin, 1, [&](int nestedBegin, int nestedEnd) {
+            for (int i = begin + nestedBegin; i < begin + nestedEnd; ++i) {
+                visits[i].fetch_add(1);
+            }
+        });
+    });
+
+    bool once = true;
+    for (const std::atomic<int>& count : visits) {
+        once = once && count.load() == 1;
+    }
+    TEST_ASSERT_TRUE(once);
+}
+
+TEST(test_ParallelForShouldRethrowExceptions) {
+    ThreadPool::setThreadCount(4);
+    bool thrown = false;
+    try {
+        ThreadPool::parallelFor(1000, 1, [](int begin, int end) {
+            if (begin <= 500 && 500 < end) {
+                throw std::runtime_error("failure");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    TEST_ASSERT_TRUE(thrown);
+}
+
+TEST(test_ThreadIndexShouldIdentifyPoolThreads) {
+    ThreadPool::setThreadCount(4);
+    std::vector<std::atomic<int>> seen(4);
+    std::atomic<bool> inRange = true;
+    // 64 items in 16 chunks of 4.
+    ThreadPool::parallelFor(64, 1, [&](int, int) {
+        const int index = ThreadPool::threadIndex();
+        if (index < 0 || index >= 4) {
+            inRange = false;
+            return;
+        }
+        seen[index].fetch_add(1);
+    });
+    ThreadPool::setThreadCount(0);
+
+    TEST_ASSERT_TRUE(inRange.load());
+    TEST_ASSERT_EQUAL_INT(0, ThreadPool::threadIndex());
+    int visits = 0;
+    for (const std::atomic<int>& count : seen) {
+        visits += count.load();
+    }
+    TEST_ASSERT_EQUAL_INT(16, visits);
+}
+
+TEST(test_ParallelResultsShouldMatchSerialBitForBit) {
+    const Matrix a = makeMatrix(301, 170, 1);
+    const Matrix b = makeMatrix(170, 259, 2);
+    const Matrix c = makeMatrix(301, 259, 3);
+
+    ThreadPool::setThreadCount(1);
+    const Matrix serialProduct = a * b;
+    const Matrix serialSum = serialProduct + c * 0.5f;
+    const Matrix serialSigmoid = ActivationFunction::sigmoid(serialSum);
+    const Matrix serialSoftmax = ActivationFunction::softmax(serialSum);
+
+    ThreadPool::setThreadCount(4);
+    const Matrix parallelProduct = a * b;
+    const Matrix parallelSum = parallelProduct + c * 0.5f;
+    const Matrix parallelSigmoid = ActivationFunction::sigmoid(parallelSum);
+    const Matrix parallelSoftmax = ActivationFunction::softmax(parallelSum);
+    ThreadPool::setThreadCount(0);
+
+    TEST_ASSERT_TRUE(bitIdentical(serialProduct, parallelProduct));
+    TEST_ASSERT_TRUE(bitIdentical(serialSum, parallelSum));
+    TEST_ASSERT_TRUE(bitIdentical(serialSigmoid, parallelSigmoid));
+    TEST_ASSERT_TRUE(bitIdentical(serialSoftmax, parallelSoftmax));
+}
+
+int main() {
+    return RunTests();
+}
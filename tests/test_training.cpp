@@ -0,0 +1,141 @@
+#define TOASTY_IMPLEMENTATION
+#include "neural_network.hpp"
+#include <iostream>
+#include "random.hpp"
+#include <sstream>
+#include <string>
+#include "training.hpp"
+#include <vector>
+
+extern "C" {
+#include "toasty.h"
+}
+
+using namespace nnn;
+
+static Matrix xorInputs() {
+    return Matrix(4, 2, { 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 1.f });
+}
+
+static Matrix xorTargets() {
+    return Matrix(4, 1, { 0.f, 1.f, 1.f, 0.f });
+}
+
+static TrainingOptions quietOptions() {
+    TrainingOptions options;
+    options.learningRate = 0.05f;
+    options.batchSize = 4;
+    options.logInterval = 0;
+    return options;
+}
+
+TEST(test_CallbackShouldSeeEveryEpochAndStopTraining) {
+    NeuralNetwork nn({ 2, 4, 1 });
+    nn.randomize(-1.f, 1.f, Random(1));
+    TrainingOptions options = quietOptions();
+    std::vector<EpochMetrics> seen;
+    options.onEpoch = [&](const EpochMetrics& metrics) {
+        seen.push_back(metrics);
+        return metrics.epoch < 4;
+    };
+
+    const TrainingResult result = nn.train(xorInputs(), xorTargets(), options);
+    TEST_ASSERT_TRUE(result.stopReason == StopReason::Callback);
+    TEST_ASSERT_EQUAL(5, result.epochs);
+    TEST_ASSERT_EQUAL(5, result.losses.size());
+    TEST_ASSERT_EQUAL(5, seen.size());
+    for (int i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL(i, seen[i].epoch);
+        TEST_ASSERT_EQUAL_FLOAT(result.losses[i], seen[i].loss);
+        TEST_ASSERT_TRUE(seen[i].epochSeconds >= 0. && seen[i].elapsedSeconds <= result.seconds);
+    }
+    TEST_ASSERT_TRUE(seen[4].elapsedSeconds >= seen[3].elapsedSeconds);
+}
+
+TEST(test_TrainingShouldStopOnceLossTargetIsReached) {
+    NeuralNetwork nn({ 2, 4, 1 }, { Activation::Tanh, Activation::Sigmoid });
+    nn.randomize(-1.f, 1.f, Random(2));
+    Random::setGlobalSeed(2);
+    TrainingOptions options = quietOptions();
+    options.epochs = 20000;
+    options.targetLoss = 0.01f;
+
+    const TrainingResult result = nn.train(xorInputs(), xorTargets(), options);
+    TEST_ASSERT_TRUE(result.stopReason == StopReason::LossTarget);
+    TEST_ASSERT_TRUE(result.epochs < options.epochs);
+    TEST_ASSERT_TRUE(result.losses.back() <= 0.01f);
+    TEST_ASSERT_TRUE(result.losses[result.epochs - 2] > 0.01f);
+}
+
+TEST(test_PlateauAndTimeBudgetShouldStopTraining) {
+    NeuralNetwork nn({ 2, 3, 1 });
+    nn.randomize(-1.f, 1.f, Random(3));
+    // Without a learning rate the loss only changes by rounding (the batch order is shuffled): the first epoch
+    // sets the best loss, and `patience` more epochs end training.
+    TrainingOptions options = quietOptions();
+    options.optimizer = OptimizerType::Sgd;
+    options.learningRate = 0.f;
+    options.patience = 3;
+    options.minImprovement = 1e-6f;
+    TrainingResult result = nn.train(xorInputs(), xorTargets(), options);
+    TEST_ASSERT_TRUE(result.stopReason == StopReason::Plateau);
+    TEST_ASSERT_EQUAL(4, result.epochs);
+
+    options = quietOptions();
+    options.mode = TrainingMode::Genetic;
+    options.timeBudgetSeconds = 1e-9;
+    result = nn.train(xorInputs(), xorTargets(), options);
+    TEST_ASSERT_TRUE(result.stopReason == StopReason::TimeBudget);
+    TEST_ASSERT_EQUAL(1, result.epochs);
+
+    options.timeBudgetSeconds = 0.;
+    options.epochs = 3;
+    result = nn.train(xorInputs(), xorTargets(), options);
+    TEST_ASSERT_TRUE(result.stopReason == StopReason::Completed);
+    TEST_ASSERT_EQUAL(3, result.epochs);
+}
+
+TEST(test_ProgressShouldBeLoggedThroughTheSink) {
+    std::ostringstream stream;
+    {
+        BufferedLogSink sink(stream);
+        for (int i = 0; i < 1000; ++i) {
+            sink.write("line " + std::to_string(i));
+        }
+        sink.flush();
+        TEST_ASSERT_EQUAL(0, stream.str().find("line 0\nline 1\n"));
+        TEST_ASSERT_TRUE(stream.str().ends_with("line 999\n"));
+
+        NeuralNetwork nn({ 2, 3, 1 });
+        TrainingOptions options = quietOptions();
+        options.epochs = 5;
+        options.logInterval = 2;
+        options.log = &sink;
+        stream.str("");
+        (void) nn.train(xorInputs(), xorTargets(), options);
+    }
+    // Destroying the sink writes out what is still pending.
+    const std::string log = stream.str();
+    TEST_ASSERT_EQUAL(0, log.find("Epoch: 0 - mean loss: "));
+    TEST_ASSERT_TRUE(log.find("\nEpoch: 2 - mean loss: ") != std::string::npos);
+    TEST_ASSERT_TRUE(log.find("\nEpoch: 4 - mean loss: ") != std::string::npos);
+    TEST_ASSERT_TRUE(log.find("Epoch: 1") == std::string::npos);
+}
+
+TEST(test_DefaultLogShouldBeWrittenBeforeTrainReturns) {
+    std::ostringstream captured;
+    std::streambuf* const original = std::cout.rdbuf(captured.rdbuf());
+    NeuralNetwork nn({ 2, 3, 1 });
+    nn.train(xorInputs(), xorTargets(), 51, 0.05f, TrainingMode::Backpropagation, OptimizerType::Adam, 4);
+    const std::string log = captured.str();
+    std::cout.rdbuf(original);
+
+    TEST_ASSERT_EQUAL(0, log.find("Epoch: 0 - mean loss: "));
+    TEST_ASSERT_TRUE(log.find("\nEpoch: 25 - mean loss: ") != std::string::npos);
+    TEST_ASSERT_TRUE(log.find("\nEpoch: 50 - mean loss: ") != std::string::npos);
+    TEST_ASSERT_TRUE(log.ends_with("\n"));
+}
+
+int main() {
+    return RunTests();
+}